@@ -0,0 +1,642 @@
+/**
+ * Micro-benchmarks for the CloudSeed DSP chain.
+ *
+ * Each stage is timed in isolation on a deterministic noise input, sweeping
+ * the settings that drive its cost (line count, tap count, diffusion stages
+ * and the factory programs for the full channel). Results are written as
+ * JSON so they can be diffed between builds to catch regressions.
+ */
+#include <algorithm>
+#include <cstdarg>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cloudseed/AllpassDiffuser.h"
+#include "cloudseed/DelayLine.h"
+#include "cloudseed/DelayReach.h"
+#include "cloudseed/LfoBank.h"
+#include "cloudseed/LineFilterBank.h"
+#include "cloudseed/ModulatedAllpass.h"
+#include "cloudseed/ModulatedDelay.h"
+#include "cloudseed/MultitapDiffuser.h"
+#include "cloudseed/PartitionedConvolver.h"
+#include "cloudseed/ReverbChannel.h"
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/audiolib/biquad.hpp"
+#include "cloudseed/presets.h"
+#include "constants.h"
+
+#define NOISE_LENGTH 4096
+
+struct BenchOptions {
+  int sample_rate = MCU_CLOCK_RATE;
+  size_t block_size = BATCH_SIZE;
+  double seconds = 1.0;
+  int repeats = 3;
+  std::string filter;
+  std::string output = "-";
+};
+
+struct BenchResult {
+  std::string stage;
+  std::string config;
+  size_t samples;
+  double best_seconds;
+  double mean_seconds;
+};
+
+static float noise[NOISE_LENGTH];
+static volatile float sink;
+
+static void fillNoise() {
+  // fixed LCG so every run sees the same input
+  std::uint32_t state = 22222;
+  for (auto& n : noise) {
+    state = state * 1664525 + 1013904223;
+    n = ((state >> 8) / (float)(1 << 24) - 0.5f);
+  }
+}
+
+static std::string jsonEscape(const std::string& text) {
+  std::string out;
+  for (auto c : text) {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    out += c;
+  }
+  return out;
+}
+
+class Bench {
+  public:
+  Bench(const BenchOptions& opts) : _opts(opts) {}
+
+  /**
+   * Times `tick(input)` over `seconds` of audio, best of `repeats` runs.
+   * `tick` must process one block and return its output.
+   */
+  template <typename TickFn>
+  void run(const std::string& stage, const std::string& config, TickFn tick) {
+    if (!_opts.filter.empty() &&
+        (stage + " " + config).find(_opts.filter) == std::string::npos)
+      return;
+
+    size_t block_size = _opts.block_size;
+    size_t blocks = _opts.seconds * _opts.sample_rate / block_size;
+    size_t noise_blocks = NOISE_LENGTH / block_size;
+
+    // warm up caches and let the modulators settle
+    for (size_t i = 0; i < blocks / 10; i++)
+      tick(&noise[(i % noise_blocks) * block_size]);
+
+    double best = 1e9;
+    double total = 0.0;
+    for (int r = 0; r < _opts.repeats; r++) {
+      float acc = 0.0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < blocks; i++) {
+        float* out = tick(&noise[(i % noise_blocks) * block_size]);
+        acc += out[0];
+      }
+      auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+      sink = acc;
+      best = std::min(best, elapsed);
+      total += elapsed;
+    }
+
+    _results.push_back(
+      {stage, config, blocks * block_size, best, total / _opts.repeats});
+    std::fprintf(stderr,
+                 "%-28s %-36s %8.1f ns/sample\n",
+                 stage.c_str(),
+                 config.c_str(),
+                 best * 1e9 / (blocks * block_size));
+  }
+
+  bool write() {
+    auto file =
+      _opts.output == "-" ? stdout : std::fopen(_opts.output.c_str(), "w");
+    if (file == nullptr) {
+      std::fprintf(stderr, "could not open %s\n", _opts.output.c_str());
+      return false;
+    }
+
+    std::fprintf(file,
+                 "{\n  \"block_size\": %zu,\n  \"sample_rate\": %d,\n"
+                 "  \"repeats\": %d,\n  \"results\": [\n",
+                 _opts.block_size,
+                 _opts.sample_rate,
+                 _opts.repeats);
+    for (size_t i = 0; i < _results.size(); i++) {
+      auto& r = _results[i];
+      double sps = r.samples / r.best_seconds;
+      std::fprintf(file,
+                   "    {\"stage\": \"%s\", \"config\": \"%s\", "
+                   "\"samples\": %zu, \"ns_per_sample\": %.3f, "
+                   "\"mean_ns_per_sample\": %.3f, \"samples_per_sec\": %.0f, "
+                   "\"realtime_load\": %.5f}%s\n",
+                   jsonEscape(r.stage).c_str(),
+                   jsonEscape(r.config).c_str(),
+                   r.samples,
+                   r.best_seconds * 1e9 / r.samples,
+                   r.mean_seconds * 1e9 / r.samples,
+                   sps,
+                   _opts.sample_rate / sps,
+                   i + 1 < _results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+
+    if (file != stdout)
+      std::fclose(file);
+    return true;
+  }
+
+  private:
+  const BenchOptions& _opts;
+  std::vector<BenchResult> _results;
+};
+
+static std::string cfg(const char* format, ...)
+  __attribute__((format(printf, 1, 2)));
+
+static std::string cfg(const char* format, ...) {
+  char buffer[128];
+  va_list args;
+  va_start(args, format);
+  std::vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  return buffer;
+}
+
+static const char* formatName(cloudSeed::SampleFormat format) {
+  switch (format) {
+  case cloudSeed::SampleFormat::Int16:
+    return "int16";
+  case cloudSeed::SampleFormat::Float16:
+    return "half";
+  default:
+    return "float";
+  }
+}
+
+static const char* kernelName(cloudSeed::Interpolation kernel) {
+  switch (kernel) {
+  case cloudSeed::Interpolation::None:
+    return "none";
+  case cloudSeed::Interpolation::Hermite:
+    return "hermite";
+  case cloudSeed::Interpolation::Allpass:
+    return "allpass";
+  default:
+    return "linear";
+  }
+}
+
+static const char* mixingName(cloudSeed::LineMixing mixing) {
+  switch (mixing) {
+  case cloudSeed::LineMixing::Householder:
+    return "householder";
+  case cloudSeed::LineMixing::Hadamard:
+    return "hadamard";
+  default:
+    return "independent";
+  }
+}
+
+static const cloudSeed::Interpolation KERNELS[] = {
+  cloudSeed::Interpolation::None,
+  cloudSeed::Interpolation::Linear,
+  cloudSeed::Interpolation::Hermite,
+  cloudSeed::Interpolation::Allpass,
+};
+
+static void benchModulatedDelay(Bench& bench, const BenchOptions& opts) {
+  struct Mode {
+    cloudSeed::SampleFormat format;
+    cloudSeed::Interpolation kernel;
+  };
+  std::vector<Mode> modes = {
+    {cloudSeed::SampleFormat::Int16, cloudSeed::Interpolation::Linear},
+    {cloudSeed::SampleFormat::Float16, cloudSeed::Interpolation::Linear},
+  };
+  for (auto kernel : KERNELS)
+    modes.push_back({cloudSeed::SampleFormat::Float32, kernel});
+
+  for (auto& mode : modes) {
+    for (float mod_amount : {0.0f, 48.0f}) {
+      for (bool staged : {false, true}) {
+        cloudSeed::LfoBank lfo(1, opts.block_size, 1);
+        auto delay = std::unique_ptr<cloudSeed::ModulatedDelay>(
+          new cloudSeed::ModulatedDelay(
+            cloudSeed::reach::lineDelay(opts.sample_rate),
+            opts.block_size,
+            lfo,
+            mode.format));
+        delay->clearBuffers();
+        delay->ksample_delay = opts.sample_rate / 2;
+        delay->kmod_amount = mod_amount;
+        delay->kinterpolation = mode.kernel;
+        delay->setModRate(1.0 / opts.sample_rate);
+        delay->setStaging(staged);
+
+        bench.run("ModulatedDelay::tick",
+                  cfg("mod_amount=%g storage=%s interpolation=%s staged=%d",
+                      mod_amount,
+                      formatName(mode.format),
+                      kernelName(mode.kernel),
+                      staged),
+                  [&](float* in) {
+                    lfo.tick(opts.block_size);
+                    return delay->tick(in, opts.block_size);
+                  });
+      }
+    }
+  }
+}
+
+static void benchModulatedAllpass(Bench& bench, const BenchOptions& opts) {
+  // the first run is unmodulated, which ignores the kernel
+  for (size_t run = 0; run <= sizeof(KERNELS) / sizeof(KERNELS[0]); run++) {
+    bool modulation = run > 0;
+    auto kernel = KERNELS[modulation ? run - 1 : 0];
+
+    cloudSeed::LfoBank lfo(1, opts.block_size, 1);
+    auto allpass = std::unique_ptr<cloudSeed::ModulatedAllpass>(
+      new cloudSeed::ModulatedAllpass(
+        ALLPASS_DELAY,
+        cloudSeed::reach::diffuserStage(opts.sample_rate),
+        opts.block_size,
+        lfo));
+    allpass->clearBuffers();
+    allpass->ksample_delay = opts.sample_rate / 20;
+    allpass->kfeedback = 0.7;
+    allpass->kmod_amount = 24.0;
+    allpass->setModRate(1.0 / opts.sample_rate);
+    allpass->kmodulation_enabled = modulation;
+    allpass->kinterpolation = kernel;
+
+    auto name = modulation
+                  ? cfg("processWithMod interpolation=%s", kernelName(kernel))
+                  : std::string("processNoMod");
+    bench.run("ModulatedAllpass::tick", name, [&](float* in) {
+      lfo.tick(opts.block_size);
+      allpass->tick(in, opts.block_size);
+      return allpass->getOutput();
+    });
+  }
+}
+
+static void benchAllpassDiffuser(Bench& bench, const BenchOptions& opts) {
+  for (size_t stages = 1; stages <= MAX_DIFFUSER_STAGE_COUNT; stages++) {
+    cloudSeed::LfoBank lfo(MAX_DIFFUSER_STAGE_COUNT, opts.block_size, 1);
+    auto diffuser = std::unique_ptr<cloudSeed::AllpassDiffuser>(
+      new cloudSeed::AllpassDiffuser(
+        cloudSeed::reach::diffuserStage(opts.sample_rate),
+        opts.sample_rate,
+        opts.block_size,
+        lfo));
+    diffuser->clearBuffers();
+    diffuser->setStages(stages);
+    diffuser->setDelay(opts.sample_rate / 20);
+    diffuser->setFeedback(0.7);
+    diffuser->setModulationEnabled(true);
+    diffuser->setModAmount(24.0);
+    diffuser->setModRate(1.0);
+
+    bench.run("AllpassDiffuser::tick",
+              cfg("stages=%zu", stages),
+              [&](float* in) {
+                lfo.tick(opts.block_size);
+                return diffuser->tick(in, opts.block_size);
+              });
+  }
+}
+
+static void benchMultitapDiffuser(Bench& bench, const BenchOptions& opts) {
+  for (size_t taps : {(size_t)1, (size_t)10, (size_t)25, MAX_DIFFUSER_TAPS}) {
+    auto multitap = std::unique_ptr<cloudSeed::MultitapDiffuser>(
+      new cloudSeed::MultitapDiffuser(
+        cloudSeed::reach::multitap(opts.sample_rate, MAX_DIFFUSER_TAPS),
+        opts.block_size));
+    multitap->clearBuffers();
+    multitap->setSeed(1);
+    multitap->setTapCount(taps);
+    multitap->setTapLength(opts.sample_rate / 4);
+    multitap->setTapGain(1.0);
+    multitap->setTapDecay(0.5);
+
+    bench.run("MultitapDiffuser::tick",
+              cfg("taps=%zu", taps),
+              [&](float* in) { return multitap->tick(in, opts.block_size); });
+  }
+}
+
+static void benchDelayLine(Bench& bench, const BenchOptions& opts) {
+  for (bool diffuser : {false, true}) {
+    cloudSeed::LfoBank lfo(1 + MAX_DIFFUSER_STAGE_COUNT, opts.block_size, 1);
+    auto line = std::unique_ptr<cloudSeed::DelayLine>(
+      new cloudSeed::DelayLine(opts.sample_rate, opts.block_size, lfo));
+    line->clearBuffers();
+    line->setDelay(opts.sample_rate / 10);
+    line->setFeedback(0.8);
+    line->setLineModAmount(24.0);
+    line->setLineModRate(1.0 / opts.sample_rate);
+    line->setDiffuserDelay(opts.sample_rate / 20);
+    line->setDiffuserFeedback(0.7);
+    line->setDiffuserStages(MAX_DIFFUSER_STAGE_COUNT);
+    line->setDiffuserModAmount(24.0);
+    line->setDiffuserModRate(1.0);
+    line->kdiffuser_enabled = diffuser;
+    line->klate_stage_tap = false;
+
+    bench.run("DelayLine::tick",
+              diffuser ? "diffuser" : "plain",
+              [&](float* in) {
+                lfo.tick(opts.block_size);
+                line->tick(in, opts.block_size);
+                return line->getOutput();
+              });
+  }
+}
+
+static void benchLfoBank(Bench& bench, const BenchOptions& opts) {
+  const size_t count = CHANNEL_LFO_COUNT;
+  for (size_t interval : {(size_t)1, (size_t)LFO_UPDATE_INTERVAL}) {
+    cloudSeed::LfoBank lfo(count, opts.block_size, 1);
+    for (size_t i = 0; i < count; i++)
+      lfo.setRate(lfo.add(), (1.0 + i * 0.1) / opts.sample_rate);
+    lfo.setUpdateInterval(interval);
+
+    std::vector<float> out(opts.block_size);
+    bench.run("LfoBank::tick",
+              cfg("lfos=%zu interval=%zu", count, interval),
+              [&](float*) {
+                lfo.tick(opts.block_size);
+                out[0] = lfo.getValue(0, 0);
+                return out.data();
+              });
+  }
+}
+
+static void benchLineFilterBank(Bench& bench, const BenchOptions& opts) {
+  cloudSeed::LfoBank lfo(
+    MAX_DELAY_LINES * (1 + MAX_DIFFUSER_STAGE_COUNT), opts.block_size, 1);
+  cloudSeed::DelayLine* lines[MAX_DELAY_LINES];
+  for (auto& line : lines) {
+    line = new cloudSeed::DelayLine(opts.sample_rate, opts.block_size, lfo);
+    line->clearBuffers();
+    line->setDelay(opts.sample_rate / 10);
+  }
+
+  cloudSeed::LineFilterBank filters(
+    MAX_DELAY_LINES, opts.sample_rate, opts.block_size);
+  filters.setLowShelfFrequency(200);
+  filters.setLowShelfGain(0.5);
+  filters.setHighShelfFrequency(8000);
+  filters.setHighShelfGain(0.5);
+  filters.setCutoffFrequency(5000);
+  filters.klow_shelf_enabled = true;
+  filters.khigh_shelf_enabled = true;
+  filters.kcutoff_enabled = true;
+
+  // the lines only provide the loop output, the filters are timed alone
+  std::vector<float> silence(opts.block_size);
+  for (auto line : lines)
+    line->tick(silence.data(), opts.block_size);
+
+  const cloudSeed::LineMixing mixings[] = {
+    cloudSeed::LineMixing::Independent,
+    cloudSeed::LineMixing::Householder,
+    cloudSeed::LineMixing::Hadamard,
+  };
+  for (size_t count = 1; count <= MAX_DELAY_LINES; count++) {
+    for (auto mixing : mixings) {
+      filters.kmixing = mixing;
+      bench.run("LineFilterBank::tick",
+                cfg("lines=%zu lanes=%d mixing=%s",
+                    count,
+                    LINE_LANE_WIDTH,
+                    mixingName(mixing)),
+                [&](float*) {
+                  filters.tick(lines, count, opts.block_size);
+                  return silence.data();
+                });
+    }
+  }
+
+  for (auto line : lines)
+    delete line;
+}
+
+static void benchBiquad(Bench& bench, const BenchOptions& opts) {
+  audioLib::Biquad shelf(audioLib::Biquad::FilterType::LowShelf,
+                         opts.sample_rate);
+  shelf.kslope = 1.0;
+  shelf.kfrequency = 200;
+  shelf.setGainDb(-6);
+
+  std::vector<float> output(opts.block_size);
+  bench.run("Biquad::tick", "low_shelf", [&](float* in) {
+    shelf.tick(in, output.data(), opts.block_size);
+    return output.data();
+  });
+}
+
+static void benchReverbChannel(Bench& bench, const BenchOptions& opts) {
+  // the controller only scales the parameters, the channel is timed directly
+  auto controller = std::unique_ptr<cloudSeed::ReverbController>(
+    new cloudSeed::ReverbController(opts.sample_rate, opts.block_size));
+  auto channel = std::unique_ptr<cloudSeed::ReverbChannel>(
+    new cloudSeed::ReverbChannel(opts.sample_rate, opts.block_size));
+  std::vector<float> output(opts.block_size);
+  std::vector<float> silence(opts.block_size, 0.0f);
+
+  for (size_t p = 0; p < FACTORY_PROGRAM_COUNT; p++) {
+    auto& program = cloudSeed::presets::FACTORY_PROGRAMS[p];
+    for (int lines = 1; lines <= MAX_DELAY_LINES; lines++) {
+      float parameters[(int)cloudSeed::Parameter::Count] = {};
+      program.init(parameters);
+      parameters[(int)cloudSeed::Parameter::LineCount] = (lines - 1) / 11.0;
+      controller->setAllParameters(parameters);
+      for (int i = 0; i < (int)cloudSeed::Parameter::Count; i++) {
+        auto param = (cloudSeed::Parameter)i;
+        channel->setParameter(param, controller->getScaledParameter(param));
+      }
+      channel->updateControls();
+      channel->clearBuffers();
+
+      bench.run("ReverbChannel::tick",
+                cfg("preset=\"%s\" lines=%d", program.name, lines),
+                [&](float* in) {
+                  channel->process(in, output.data(), opts.block_size);
+                  return output.data();
+                });
+    }
+
+    // a pedal waiting for input, once the tail has died out
+    channel->clearBuffers();
+    while (!channel->isIdle())
+      channel->process(silence.data(), output.data(), opts.block_size);
+    bench.run("ReverbChannel::tick",
+              cfg("preset=\"%s\" lines=%d idle", program.name, MAX_DELAY_LINES),
+              [&](float*) {
+                channel->process(
+                  silence.data(), output.data(), opts.block_size);
+                return output.data();
+              });
+  }
+
+  // the late lines at a reduced rate, with every line running
+  auto& fast = fastArena();
+  auto& sdram = sdramArena();
+  for (auto rate : {cloudSeed::LateRate::Half, cloudSeed::LateRate::Quarter}) {
+    auto fast_mark = fast.mark();
+    auto sdram_mark = sdram.mark();
+    {
+      auto eco = std::unique_ptr<cloudSeed::ReverbChannel>(
+        new cloudSeed::ReverbChannel(opts.sample_rate,
+                                     opts.block_size,
+                                     cloudSeed::StorageConfig(),
+                                     rate));
+      for (size_t p = 0; p < FACTORY_PROGRAM_COUNT; p++) {
+        auto& program = cloudSeed::presets::FACTORY_PROGRAMS[p];
+        float parameters[(int)cloudSeed::Parameter::Count] = {};
+        program.init(parameters);
+        parameters[(int)cloudSeed::Parameter::LineCount] = 1.0;
+        controller->setAllParameters(parameters);
+        for (int i = 0; i < (int)cloudSeed::Parameter::Count; i++) {
+          auto param = (cloudSeed::Parameter)i;
+          eco->setParameter(param, controller->getScaledParameter(param));
+        }
+        eco->updateControls();
+        eco->clearBuffers();
+
+        bench.run("ReverbChannel::tick",
+                  cfg("preset=\"%s\" lines=%d late_rate=%d",
+                      program.name,
+                      MAX_DELAY_LINES,
+                      (int)rate),
+                  [&](float* in) {
+                    eco->process(in, output.data(), opts.block_size);
+                    return output.data();
+                  });
+      }
+    }
+    fast.rewind(fast_mark);
+    sdram.rewind(sdram_mark);
+  }
+}
+
+static void benchPartitionedConvolver(Bench& bench, const BenchOptions& opts) {
+  auto& fast = fastArena();
+  auto& sdram = sdramArena();
+  for (double seconds : {1.0, 4.0, 16.0}) {
+    // a decaying noise tail, the cost only depends on the length
+    size_t length = seconds * opts.sample_rate;
+    std::vector<float> response(length);
+    for (size_t i = 0; i < length; i++)
+      response[i] = noise[i % NOISE_LENGTH] * std::exp(-6.9 * i / length);
+
+    for (size_t partition : {(size_t)64, (size_t)128, (size_t)256}) {
+      // the responses are too large to keep side by side
+      auto fast_mark = fast.mark();
+      auto sdram_mark = sdram.mark();
+      {
+        auto convolver = std::unique_ptr<cloudSeed::PartitionedConvolver>(
+          new cloudSeed::PartitionedConvolver(partition, length));
+        convolver->setImpulseResponse(response.data(), length);
+
+        std::vector<float> output(opts.block_size);
+        bench.run("PartitionedConvolver::process",
+                  cfg("response=%gs partition=%zu", seconds, partition),
+                  [&](float* in) {
+                    convolver->process(in, output.data(), opts.block_size);
+                    return output.data();
+                  });
+      }
+      fast.rewind(fast_mark);
+      sdram.rewind(sdram_mark);
+    }
+  }
+}
+
+static void printUsage() {
+  std::fprintf(
+    stderr,
+    "usage: cloudseed_benchmark [options]\n"
+    "\n"
+    "  -b, --block-size N  samples processed per tick, max %d (default %d)\n"
+    "      --rate HZ       engine sample rate (default %d)\n"
+    "  -s, --seconds S     audio per measurement (default 1)\n"
+    "  -r, --repeats N     measurements per config, best is kept (default 3)\n"
+    "  -f, --filter TEXT   only run configs whose name contains TEXT\n"
+    "  -o, --output FILE   JSON destination (default stdout)\n",
+    NOISE_LENGTH,
+    BATCH_SIZE,
+    MCU_CLOCK_RATE);
+}
+
+int main(int argc, char** argv) {
+  BenchOptions opts;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+    if (i + 1 >= argc) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+
+    const char* value = argv[++i];
+    if (arg == "-b" || arg == "--block-size") {
+      opts.block_size = std::strtoul(value, nullptr, 10);
+    } else if (arg == "--rate") {
+      opts.sample_rate = std::atoi(value);
+    } else if (arg == "-s" || arg == "--seconds") {
+      opts.seconds = std::atof(value);
+    } else if (arg == "-r" || arg == "--repeats") {
+      opts.repeats = std::max(1, std::atoi(value));
+    } else if (arg == "-f" || arg == "--filter") {
+      opts.filter = value;
+    } else if (arg == "-o" || arg == "--output") {
+      opts.output = value;
+    } else {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (opts.block_size == 0 || opts.block_size > NOISE_LENGTH ||
+      opts.sample_rate < 8000 || opts.sample_rate > 192000) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  cloudSeed::utils::enableFlushToZero();
+  fillNoise();
+
+  Bench bench(opts);
+  benchModulatedDelay(bench, opts);
+  benchModulatedAllpass(bench, opts);
+  benchAllpassDiffuser(bench, opts);
+  benchMultitapDiffuser(bench, opts);
+  benchDelayLine(bench, opts);
+  benchLfoBank(bench, opts);
+  benchLineFilterBank(bench, opts);
+  benchBiquad(bench, opts);
+  benchReverbChannel(bench, opts);
+  benchPartitionedConvolver(bench, opts);
+
+  return bench.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+/**
+ * Host implementation of the SDRAM arena.
+ *
+ * On the Daisy the arena is a fixed array placed in SDRAM, on the host it is
+ * an anonymous mapping so the offline tools can run the engine unchanged.
+ * The fast arena is a plain array of the firmware's size on both, so the
+ * host places buffers in the same tiers the pedal does.
+ */
+#include <cstdlib>
+#include <sys/mman.h>
+
+#include "allocator.hpp"
+#include "hostallocator.hpp"
+
+#define HOST_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+alignas(ARENA_ALIGNMENT) static char host_fast_pool[FAST_POOL_SIZE];
+static void* host_pool = nullptr;
+static size_t host_pool_size = 0;
+static bool host_pool_huge = false;
+
+static void abortOnFailure(const char* tag, size_t bytes) {
+  std::fprintf(stderr,
+               "arena: no room for %zu bytes of %s, %zu of %zu left\n",
+               bytes,
+               tag,
+               sdramArena().remaining(),
+               sdramArena().capacity());
+  std::abort();
+}
+
+static Arena& hostArena() {
+  // function local, so it exists before any static constructor allocates
+  static Arena arena(nullptr, 0, abortOnFailure);
+  return arena;
+}
+
+bool hostArenaInit(size_t bytes, bool huge_pages) {
+  auto& arena = hostArena();
+  if (arena.used() > 0)
+    return false;
+
+  if (host_pool != nullptr) {
+    munmap(host_pool, host_pool_size);
+    host_pool = nullptr;
+  }
+
+  // anonymous mappings are zeroed, like the BSS the firmware pool lives in
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+  void* pool = MAP_FAILED;
+  host_pool_huge = false;
+#ifdef MAP_HUGETLB
+  if (huge_pages) {
+    auto huge_bytes = (bytes + HOST_HUGE_PAGE_SIZE - 1) &
+                      ~(size_t)(HOST_HUGE_PAGE_SIZE - 1);
+    // reserved, so the mapping fails up front rather than faulting later if
+    // the system has too few huge pages
+    pool = mmap(nullptr,
+                huge_bytes,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                -1,
+                0);
+    if (pool != MAP_FAILED) {
+      bytes = huge_bytes;
+      host_pool_huge = true;
+    }
+  }
+#endif
+  if (pool == MAP_FAILED) {
+    pool = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (pool == MAP_FAILED) {
+      arena.init(nullptr, 0);
+      return false;
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge_pages)
+      madvise(pool, bytes, MADV_HUGEPAGE);
+#endif
+  }
+
+  host_pool = pool;
+  host_pool_size = bytes;
+  arena.init(pool, bytes);
+  return true;
+}
+
+bool hostArenaOnHugePages() {
+  return host_pool_huge;
+}
+
+static void reportUsage(std::FILE* file, Arena& arena) {
+  Arena::TagUsage usage[32];
+  auto tags = arena.usageByTag(usage, 32);
+  for (size_t i = 0; i < tags && i < 32; i++) {
+    std::fprintf(file,
+                 "  %-16s %10.1f KB in %zu\n",
+                 usage[i].tag,
+                 usage[i].bytes / 1024.0,
+                 usage[i].count);
+  }
+}
+
+void hostArenaReport(std::FILE* file) {
+  auto& fast = fastArena();
+  std::fprintf(file, "  fast internal RAM:\n");
+  reportUsage(file, fast);
+  std::fprintf(file,
+               "  used %.1f KB, %.1f KB left, %zu allocations of %.1f KB "
+               "fell back to SDRAM\n",
+               fast.used() / 1024.0,
+               fast.remaining() / 1024.0,
+               fast.failures(),
+               fast.failedBytes() / 1024.0);
+
+  auto& arena = sdramArena();
+  std::fprintf(file, "  SDRAM:\n");
+  reportUsage(file, arena);
+  std::fprintf(file,
+               "  used %.2f MB, high water %.2f MB, %.2f MB left%s\n",
+               arena.used() / (1024.0 * 1024.0),
+               arena.highWaterMark() / (1024.0 * 1024.0),
+               arena.remaining() / (1024.0 * 1024.0),
+               host_pool_huge ? " on huge pages" : "");
+}
+
+Arena& sdramArena() {
+  if (host_pool == nullptr)
+    hostArenaInit(HOST_POOL_SIZE, false);
+  return hostArena();
+}
+
+Arena& fastArena() {
+  // no failure handler, what does not fit falls back to SDRAM
+  static Arena arena(host_fast_pool, FAST_POOL_SIZE);
+  return arena;
+}
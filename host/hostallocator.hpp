@@ -0,0 +1,31 @@
+/**
+ * Setup of the host backend of the SDRAM arena.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+
+// Larger than the 61MB Daisy pool, host runs are not memory constrained. The
+// pages are only committed once touched.
+#define HOST_POOL_SIZE (256 * 1024 * 1024)
+
+/**
+ * Maps `bytes` of zeroed memory for the arena, releasing the previous
+ * mapping. With `huge_pages` explicit huge pages are tried first, then
+ * transparent ones are asked for. Returns false if nothing could be mapped
+ * or the arena is already in use. Without a call the arena maps
+ * HOST_POOL_SIZE on normal pages on its first use.
+ */
+bool hostArenaInit(size_t bytes, bool huge_pages);
+
+/**
+ * The arena is on explicit huge pages.
+ */
+bool hostArenaOnHugePages();
+
+/**
+ * Prints the use of the fast and the SDRAM arena by tag to `file`, and how
+ * much asked for fast memory but fell back to SDRAM.
+ */
+void hostArenaReport(std::FILE* file);
@@ -0,0 +1,570 @@
+/**
+ * Offline renderer for the CloudSeed engine.
+ *
+ * Runs `cloudSeed::ReverbController` over a WAV file or a raw float stream
+ * with one of the factory programs applied, keeps rendering the tail after
+ * the input ends until it decays below a threshold, and reports throughput.
+ * No Daisy hardware is involved, so this is the starting point for profiling
+ * and iterating on the DSP.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cloudseed/MemoryPlan.h"
+#include "cloudseed/PartitionedConvolver.h"
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/presets.h"
+#include "constants.h"
+#include "hostallocator.hpp"
+#include "wavfile.hpp"
+
+struct RenderOptions {
+  size_t preset = 0;
+  int line_count = MAX_DELAY_LINES;
+  size_t block_size = BATCH_SIZE;
+  std::uint32_t raw_sample_rate = MCU_CLOCK_RATE;
+  bool raw_in = false;
+  bool raw_out = false;
+  float threshold_db = -90.0;
+  float hold_seconds = 2.0;
+  float max_tail_seconds = 60.0;
+  size_t mod_interval = LFO_UPDATE_INTERVAL;
+  bool huge_pages = false;
+  bool memory_report = false;
+  bool freeze = false;
+  bool profile = false;
+  size_t partition_size = CONVOLUTION_PARTITION_SIZE;
+  cloudSeed::StorageConfig storage;
+  cloudSeed::InterpolationConfig interpolation;
+  cloudSeed::LineMixing mixing = cloudSeed::LineMixing::Independent;
+  cloudSeed::LateRate late_rate = cloudSeed::LateRate::Full;
+  std::string input;
+  std::string output;
+};
+
+static void printUsage() {
+  std::fprintf(
+    stderr,
+    "usage: cloudseed_render [options] <input> <output>\n"
+    "\n"
+    "  -p, --preset N        factory program index (default 0), see --list\n"
+    "  -n, --lines N         late reverb delay lines, 1-%d (default %d)\n"
+    "  -b, --block-size N    samples processed per tick (default %d)\n"
+    "  -r, --rate HZ         sample rate of raw input (default %d)\n"
+    "      --raw-in          input is raw 32 bit float mono, - for stdin\n"
+    "      --raw-out         output is raw 32 bit float mono, - for stdout\n"
+    "  -t, --threshold DB    tail level that ends the render (default -90)\n"
+    "      --hold SECONDS    time the tail must stay below it (default 2)\n"
+    "      --max-tail SECONDS  upper bound on the tail length (default 60)\n"
+    "  -s, --storage SPEC    delay memory format, float, int16 or half for\n"
+    "                        every stage, or STAGE=FORMAT[,...] with stages\n"
+    "                        predelay, multitap, diffuser, line and\n"
+    "                        line_diffuser (default float)\n"
+    "  -i, --interpolation SPEC  fractional delay kernel, none, linear,\n"
+    "                        hermite or allpass for every modulated stage,\n"
+    "                        or STAGE=KERNEL[,...] with stages predelay,\n"
+    "                        diffuser, line and line_diffuser (default\n"
+    "                        linear)\n"
+    "      --mod-interval N  samples between modulation updates (default %d)\n"
+    "  -m, --mixing MODE     how the late lines feed back, independent,\n"
+    "                        householder or hadamard (default independent)\n"
+    "      --late-rate RATE  rate of the late lines, full, half or quarter\n"
+    "                        (default full)\n"
+    "      --freeze          render the impulse response of the program and\n"
+    "                        convolve with it instead\n"
+    "      --partition N     samples per partition of the frozen response\n"
+    "                        (default %d)\n"
+    "      --profile         list the time each engine stage takes per\n"
+    "                        block\n"
+    "      --huge-pages      back the engine memory with huge pages\n"
+    "      --memory          list the engine memory by stage\n"
+    "  -l, --list            list the factory programs\n",
+    MAX_DELAY_LINES,
+    MAX_DELAY_LINES,
+    BATCH_SIZE,
+    MCU_CLOCK_RATE,
+    LFO_UPDATE_INTERVAL,
+    CONVOLUTION_PARTITION_SIZE);
+}
+
+static void printPresets() {
+  for (size_t i = 0; i < FACTORY_PROGRAM_COUNT; i++)
+    std::printf("%zu: %s\n", i, cloudSeed::presets::FACTORY_PROGRAMS[i].name);
+}
+
+static bool parseFormat(const std::string& name,
+                        cloudSeed::SampleFormat& format) {
+  if (name == "float")
+    format = cloudSeed::SampleFormat::Float32;
+  else if (name == "int16")
+    format = cloudSeed::SampleFormat::Int16;
+  else if (name == "half")
+    format = cloudSeed::SampleFormat::Float16;
+  else
+    return false;
+  return true;
+}
+
+/**
+ * Parses a --storage value into `storage`, returns false if it is malformed.
+ */
+static bool parseStorage(const std::string& spec,
+                         cloudSeed::StorageConfig& storage) {
+  cloudSeed::SampleFormat format;
+  if (parseFormat(spec, format)) {
+    storage.pre_delay = format;
+    storage.multitap = format;
+    storage.diffuser = format;
+    storage.line_delay = format;
+    storage.line_diffuser = format;
+    return true;
+  }
+
+  size_t start = 0;
+  while (start <= spec.size()) {
+    auto end = std::min(spec.find(',', start), spec.size());
+    auto entry = spec.substr(start, end - start);
+    auto equals = entry.find('=');
+    if (equals == std::string::npos ||
+        !parseFormat(entry.substr(equals + 1), format))
+      return false;
+
+    auto stage = entry.substr(0, equals);
+    if (stage == "predelay")
+      storage.pre_delay = format;
+    else if (stage == "multitap")
+      storage.multitap = format;
+    else if (stage == "diffuser")
+      storage.diffuser = format;
+    else if (stage == "line")
+      storage.line_delay = format;
+    else if (stage == "line_diffuser")
+      storage.line_diffuser = format;
+    else
+      return false;
+
+    start = end + 1;
+  }
+  return true;
+}
+
+static bool parseKernel(const std::string& name,
+                        cloudSeed::Interpolation& kernel) {
+  if (name == "none")
+    kernel = cloudSeed::Interpolation::None;
+  else if (name == "linear")
+    kernel = cloudSeed::Interpolation::Linear;
+  else if (name == "hermite")
+    kernel = cloudSeed::Interpolation::Hermite;
+  else if (name == "allpass")
+    kernel = cloudSeed::Interpolation::Allpass;
+  else
+    return false;
+  return true;
+}
+
+/**
+ * Parses an --interpolation value into `interpolation`, returns false if it
+ * is malformed.
+ */
+static bool parseInterpolation(const std::string& spec,
+                               cloudSeed::InterpolationConfig& interpolation) {
+  cloudSeed::Interpolation kernel;
+  if (parseKernel(spec, kernel)) {
+    interpolation.pre_delay = kernel;
+    interpolation.diffuser = kernel;
+    interpolation.line_delay = kernel;
+    interpolation.line_diffuser = kernel;
+    return true;
+  }
+
+  size_t start = 0;
+  while (start <= spec.size()) {
+    auto end = std::min(spec.find(',', start), spec.size());
+    auto entry = spec.substr(start, end - start);
+    auto equals = entry.find('=');
+    if (equals == std::string::npos ||
+        !parseKernel(entry.substr(equals + 1), kernel))
+      return false;
+
+    auto stage = entry.substr(0, equals);
+    if (stage == "predelay")
+      interpolation.pre_delay = kernel;
+    else if (stage == "diffuser")
+      interpolation.diffuser = kernel;
+    else if (stage == "line")
+      interpolation.line_delay = kernel;
+    else if (stage == "line_diffuser")
+      interpolation.line_diffuser = kernel;
+    else
+      return false;
+
+    start = end + 1;
+  }
+  return true;
+}
+
+static bool parseMixing(const std::string& name,
+                        cloudSeed::LineMixing& mixing) {
+  if (name == "independent")
+    mixing = cloudSeed::LineMixing::Independent;
+  else if (name == "householder")
+    mixing = cloudSeed::LineMixing::Householder;
+  else if (name == "hadamard")
+    mixing = cloudSeed::LineMixing::Hadamard;
+  else
+    return false;
+  return true;
+}
+
+static bool parseLateRate(const std::string& name,
+                          cloudSeed::LateRate& late_rate) {
+  if (name == "full")
+    late_rate = cloudSeed::LateRate::Full;
+  else if (name == "half")
+    late_rate = cloudSeed::LateRate::Half;
+  else if (name == "quarter")
+    late_rate = cloudSeed::LateRate::Quarter;
+  else
+    return false;
+  return true;
+}
+
+/**
+ * Returns false if the program should exit, `exit_code` holds the status.
+ */
+static bool
+parseArgs(int argc, char** argv, RenderOptions& opts, int& exit_code) {
+  exit_code = EXIT_FAILURE;
+  int positional = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char* {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "%s needs a value\n", arg.c_str());
+        return nullptr;
+      }
+      return argv[++i];
+    };
+
+    if (arg == "-h" || arg == "--help") {
+      printUsage();
+      exit_code = EXIT_SUCCESS;
+      return false;
+    } else if (arg == "-l" || arg == "--list") {
+      printPresets();
+      exit_code = EXIT_SUCCESS;
+      return false;
+    } else if (arg == "--raw-in") {
+      opts.raw_in = true;
+    } else if (arg == "--raw-out") {
+      opts.raw_out = true;
+    } else if (arg == "--huge-pages") {
+      opts.huge_pages = true;
+    } else if (arg == "--memory") {
+      opts.memory_report = true;
+    } else if (arg == "--freeze") {
+      opts.freeze = true;
+    } else if (arg == "--profile") {
+      opts.profile = true;
+    } else if (arg == "-p" || arg == "--preset" || arg == "-n" ||
+               arg == "--lines" || arg == "-b" || arg == "--block-size" ||
+               arg == "-r" || arg == "--rate" ||
+               arg == "-t" || arg == "--threshold" || arg == "--hold" ||
+               arg == "--max-tail" || arg == "-s" || arg == "--storage" ||
+               arg == "--mod-interval" || arg == "-i" ||
+               arg == "--interpolation" || arg == "-m" ||
+               arg == "--mixing" || arg == "--partition" ||
+               arg == "--late-rate") {
+      auto v = value();
+      if (v == nullptr)
+        return false;
+
+      if (arg == "-p" || arg == "--preset")
+        opts.preset = std::strtoul(v, nullptr, 10);
+      else if (arg == "-n" || arg == "--lines")
+        opts.line_count = std::atoi(v);
+      else if (arg == "-b" || arg == "--block-size")
+        opts.block_size = std::strtoul(v, nullptr, 10);
+      else if (arg == "-r" || arg == "--rate")
+        opts.raw_sample_rate = std::strtoul(v, nullptr, 10);
+      else if (arg == "-t" || arg == "--threshold")
+        opts.threshold_db = std::atof(v);
+      else if (arg == "--hold")
+        opts.hold_seconds = std::atof(v);
+      else if (arg == "--mod-interval")
+        opts.mod_interval = std::strtoul(v, nullptr, 10);
+      else if (arg == "--partition")
+        opts.partition_size = std::strtoul(v, nullptr, 10);
+      else if (arg == "-s" || arg == "--storage") {
+        if (!parseStorage(v, opts.storage)) {
+          std::fprintf(stderr, "invalid storage %s\n", v);
+          return false;
+        }
+      } else if (arg == "-i" || arg == "--interpolation") {
+        if (!parseInterpolation(v, opts.interpolation)) {
+          std::fprintf(stderr, "invalid interpolation %s\n", v);
+          return false;
+        }
+      } else if (arg == "-m" || arg == "--mixing") {
+        if (!parseMixing(v, opts.mixing)) {
+          std::fprintf(stderr, "invalid mixing %s\n", v);
+          return false;
+        }
+      } else if (arg == "--late-rate") {
+        if (!parseLateRate(v, opts.late_rate)) {
+          std::fprintf(stderr, "invalid late rate %s\n", v);
+          return false;
+        }
+      } else
+        opts.max_tail_seconds = std::atof(v);
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+      printUsage();
+      return false;
+    } else if (positional == 0) {
+      opts.input = arg;
+      positional++;
+    } else if (positional == 1) {
+      opts.output = arg;
+      positional++;
+    } else {
+      printUsage();
+      return false;
+    }
+  }
+
+  if (positional != 2) {
+    printUsage();
+    return false;
+  }
+  if (opts.preset >= FACTORY_PROGRAM_COUNT) {
+    std::fprintf(stderr, "preset must be 0-%d\n", FACTORY_PROGRAM_COUNT - 1);
+    return false;
+  }
+  if (opts.line_count < 1 || opts.line_count > MAX_DELAY_LINES) {
+    std::fprintf(stderr, "lines must be 1-%d\n", MAX_DELAY_LINES);
+    return false;
+  }
+  if (opts.block_size == 0) {
+    std::fprintf(stderr, "block size must be at least 1\n");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * The rate of profiling::now(), timed against the steady clock.
+ */
+static double measureTickRate() {
+  auto start = std::chrono::steady_clock::now();
+  auto start_ticks = cloudSeed::profiling::now();
+  double elapsed = 0;
+  while (elapsed < 0.05) {
+    elapsed = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  }
+  return (uint32_t)(cloudSeed::profiling::now() - start_ticks) / elapsed;
+}
+
+static void printProfile(const cloudSeed::Profiler& profiler) {
+  auto ns_per_tick = 1e9 / measureTickRate();
+  std::fprintf(stderr,
+               "  %-16s %8s %9s %9s %9s %9s  (ns per block)\n",
+               "stage",
+               "blocks",
+               "min",
+               "mean",
+               "p99",
+               "max");
+  for (size_t s = 0; s < profiler.getStageCount(); s++) {
+    auto& histogram = profiler.getHistogram(s);
+    if (histogram.getCount() == 0)
+      continue;
+    std::fprintf(stderr,
+                 "  %-16s %8u %9.0f %9.0f %9.0f %9.0f\n",
+                 profiler.getName(s),
+                 histogram.getCount(),
+                 histogram.getMin() * ns_per_tick,
+                 histogram.getMean() * ns_per_tick,
+                 histogram.getPercentile(0.99) * ns_per_tick,
+                 histogram.getMax() * ns_per_tick);
+  }
+}
+
+int main(int argc, char** argv) {
+  RenderOptions opts;
+  int exit_code;
+  if (!parseArgs(argc, argv, opts, exit_code))
+    return exit_code;
+
+  AudioData input;
+  if (opts.raw_in) {
+    input.sample_rate = opts.raw_sample_rate;
+    if (!readRaw(opts.input, input))
+      return EXIT_FAILURE;
+  } else if (!readWav(opts.input, input)) {
+    return EXIT_FAILURE;
+  }
+
+  if (input.sample_rate < 8000 || input.sample_rate > 192000) {
+    std::fprintf(stderr, "unsupported sample rate %u\n", input.sample_rate);
+    return EXIT_FAILURE;
+  }
+
+  cloudSeed::utils::enableFlushToZero();
+
+  if (opts.huge_pages && !hostArenaInit(HOST_POOL_SIZE, true)) {
+    std::fprintf(stderr, "could not map the engine memory\n");
+    return EXIT_FAILURE;
+  }
+
+  // far too large for the stack
+  std::unique_ptr<cloudSeed::ReverbController> reverb(
+    new cloudSeed::ReverbController(
+      input.sample_rate, opts.block_size, opts.storage, opts.late_rate));
+
+  float parameters[(int)cloudSeed::Parameter::Count] = {};
+  cloudSeed::presets::FACTORY_PROGRAMS[opts.preset].init(parameters);
+  // inverse of the LineCount scaling in ReverbController::getScaledParameter
+  parameters[(int)cloudSeed::Parameter::LineCount] =
+    (opts.line_count - 1) / 11.0;
+  reverb->setAllParameters(parameters);
+  reverb->setModulationInterval(opts.mod_interval);
+  reverb->setInterpolation(opts.interpolation);
+  reverb->setLineMixing(opts.mixing);
+  reverb->updateControls();
+  reverb->clearBuffers();
+
+  // too large for the stack as well
+  std::unique_ptr<cloudSeed::Profiler> profiler;
+  if (opts.profile)
+    profiler.reset(new cloudSeed::Profiler());
+
+  float threshold = std::pow(10.0, opts.threshold_db / 20.0);
+  size_t hold_samples = opts.hold_seconds * input.sample_rate;
+  size_t max_tail_samples = opts.max_tail_seconds * input.sample_rate;
+
+  // the response is rendered before the clock starts, only its playback is
+  // timed
+  std::unique_ptr<cloudSeed::PartitionedConvolver> convolver;
+  if (opts.freeze) {
+    std::vector<float> response(max_tail_samples);
+    auto length =
+      reverb->renderImpulseResponse(response.data(), response.size());
+    convolver.reset(
+      new cloudSeed::PartitionedConvolver(opts.partition_size, length));
+    convolver->setImpulseResponse(response.data(), length);
+  }
+  // after the response is rendered, so only the timed blocks are recorded
+  reverb->setProfiler(profiler.get());
+  auto process = [&](const float* in, float* out, size_t len) {
+    if (convolver)
+      convolver->process(in, out, len);
+    else
+      reverb->process(in, out, len);
+  };
+
+  AudioData output;
+  output.sample_rate = input.sample_rate;
+  output.samples.reserve(input.samples.size() + hold_samples);
+  output.samples = input.samples;
+
+  size_t block_size = opts.block_size;
+  std::vector<float> tail_block(block_size);
+  size_t tail_samples = 0;
+  size_t quiet_samples = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  // the input is rendered in place in a single call, the engine splits it
+  // into blocks itself
+  process(
+    output.samples.data(), output.samples.data(), output.samples.size());
+
+  while (quiet_samples < hold_samples && tail_samples < max_tail_samples) {
+    std::fill(tail_block.begin(), tail_block.end(), 0.0f);
+    process(tail_block.data(), tail_block.data(), block_size);
+    output.samples.insert(
+      output.samples.end(), tail_block.begin(), tail_block.end());
+    tail_samples += block_size;
+
+    float peak = 0.0;
+    for (auto sample : tail_block)
+      peak = std::max(peak, std::fabs(sample));
+    quiet_samples = peak < threshold ? quiet_samples + block_size : 0;
+  }
+  auto elapsed = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+
+  size_t pos = output.samples.size();
+
+  // drop the silent hold period at the end of the tail
+  output.samples.resize(output.samples.size() - quiet_samples);
+
+  bool written = opts.raw_out ? writeRaw(opts.output, output)
+                              : writeWav(opts.output, output);
+  if (!written)
+    return EXIT_FAILURE;
+
+  double audio_seconds = pos / (double)input.sample_rate;
+  std::fprintf(stderr,
+               "%s, %d lines, %u Hz, %zu sample blocks\n"
+               "  %zu samples (%.2f s) in %.3f s\n"
+               "  %.1f ns/sample, %.0f samples/sec, %.1fx realtime\n"
+               "  arena used: %.2f MB\n",
+               cloudSeed::presets::FACTORY_PROGRAMS[opts.preset].name,
+               opts.line_count,
+               input.sample_rate,
+               block_size,
+               pos,
+               audio_seconds,
+               elapsed,
+               elapsed * 1e9 / pos,
+               pos / elapsed,
+               audio_seconds / elapsed,
+               sdramArena().used() / (1024.0 * 1024.0));
+  if (convolver) {
+    std::fprintf(stderr,
+                 "  frozen into %zu partitions of %zu samples (%.2f s)\n",
+                 convolver->getPartitions() + 1,
+                 convolver->getPartitionSize(),
+                 (convolver->getPartitions() + 1) *
+                   convolver->getPartitionSize() /
+                   (double)input.sample_rate);
+  }
+  if (profiler && !convolver)
+    printProfile(*profiler);
+  if (opts.memory_report) {
+    hostArenaReport(stderr);
+    auto plan = cloudSeed::planMemory(
+      {(int)input.sample_rate, opts.block_size, opts.storage, opts.late_rate});
+    std::fprintf(stderr,
+                 "  planned %.2f MB of SDRAM, %.2f MB with every fast "
+                 "buffer in it, of the %.2f MB pool\n"
+                 "  planned %.1f KB of fast buffers for the %.1f KB fast "
+                 "pool\n"
+                 "  planned %.1f KB of objects, %.1f KB internal RAM budget "
+                 "left\n",
+                 plan.sdram / (1024.0 * 1024.0),
+                 (plan.sdram + plan.fast) / (1024.0 * 1024.0),
+                 SDRAM_POOL_SIZE / (1024.0 * 1024.0),
+                 plan.fast / 1024.0,
+                 FAST_POOL_SIZE / 1024.0,
+                 plan.objects / 1024.0,
+                 ((double)SRAM_BUDGET - FAST_POOL_SIZE - plan.objects) /
+                   1024.0);
+  }
+
+  return EXIT_SUCCESS;
+}
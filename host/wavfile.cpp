@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "wavfile.hpp"
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+static std::uint32_t readLe(const unsigned char* bytes, size_t len) {
+  std::uint32_t value = 0;
+  for (size_t i = 0; i < len; i++)
+    value |= (std::uint32_t)bytes[i] << (8 * i);
+  return value;
+}
+
+static void writeLe(std::FILE* file, std::uint32_t value, size_t len) {
+  for (size_t i = 0; i < len; i++)
+    std::fputc((value >> (8 * i)) & 0xFF, file);
+}
+
+static float decodeSample(const unsigned char* bytes,
+                          std::uint16_t format,
+                          std::uint16_t bits) {
+  if (format == WAV_FORMAT_FLOAT) {
+    float value;
+    std::uint32_t raw = readLe(bytes, 4);
+    memcpy(&value, &raw, sizeof(float));
+    return value;
+  }
+
+  // sign extend the PCM sample into the top of an int32
+  auto raw = readLe(bytes, bits / 8) << (32 - bits);
+  return (std::int32_t)raw / 2147483648.0f;
+}
+
+static std::FILE* openFile(const std::string& path, const char* mode) {
+  auto file = std::fopen(path.c_str(), mode);
+  if (file == nullptr)
+    std::fprintf(stderr, "could not open %s\n", path.c_str());
+  return file;
+}
+
+bool readWav(const std::string& path, AudioData& out) {
+  auto file = openFile(path, "rb");
+  if (file == nullptr)
+    return false;
+
+  std::vector<unsigned char> bytes;
+  unsigned char chunk[4096];
+  size_t read;
+  while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    bytes.insert(bytes.end(), chunk, chunk + read);
+  std::fclose(file);
+
+  if (bytes.size() < 12 || memcmp(bytes.data(), "RIFF", 4) != 0 ||
+      memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+    std::fprintf(stderr, "%s is not a RIFF/WAVE file\n", path.c_str());
+    return false;
+  }
+
+  std::uint16_t format = 0;
+  std::uint16_t channels = 0;
+  std::uint16_t bits = 0;
+  const unsigned char* data = nullptr;
+  size_t data_size = 0;
+
+  size_t pos = 12;
+  while (pos + 8 <= bytes.size()) {
+    auto id = bytes.data() + pos;
+    size_t size = readLe(id + 4, 4);
+    auto body = id + 8;
+    size = std::min(size, bytes.size() - pos - 8);
+
+    if (memcmp(id, "fmt ", 4) == 0 && size >= 16) {
+      format = readLe(body, 2);
+      channels = readLe(body + 2, 2);
+      out.sample_rate = readLe(body + 4, 4);
+      bits = readLe(body + 14, 2);
+      if (format == WAV_FORMAT_EXTENSIBLE && size >= 26)
+        format = readLe(body + 24, 2);
+    } else if (memcmp(id, "data", 4) == 0) {
+      data = body;
+      data_size = size;
+    }
+
+    // chunks are padded to an even length
+    pos += 8 + size + (size & 1);
+  }
+
+  bool supported = (format == WAV_FORMAT_PCM &&
+                    (bits == 16 || bits == 24 || bits == 32)) ||
+                   (format == WAV_FORMAT_FLOAT && bits == 32);
+  if (data == nullptr || channels == 0 || !supported) {
+    std::fprintf(stderr,
+                 "%s: unsupported WAV (format %u, %u bit, %u channels)\n",
+                 path.c_str(),
+                 format,
+                 bits,
+                 channels);
+    return false;
+  }
+
+  size_t frame_bytes = channels * (bits / 8);
+  size_t frames = data_size / frame_bytes;
+  out.samples.resize(frames);
+  for (size_t i = 0; i < frames; i++) {
+    float sum = 0.0;
+    for (size_t c = 0; c < channels; c++) {
+      auto sample = data + i * frame_bytes + c * (bits / 8);
+      sum += decodeSample(sample, format, bits);
+    }
+    out.samples[i] = sum / channels;
+  }
+
+  return true;
+}
+
+bool writeWav(const std::string& path, const AudioData& data) {
+  auto file = openFile(path, "wb");
+  if (file == nullptr)
+    return false;
+
+  std::uint32_t data_size = data.samples.size() * sizeof(float);
+
+  std::fwrite("RIFF", 1, 4, file);
+  writeLe(file, 36 + data_size, 4);
+  std::fwrite("WAVE", 1, 4, file);
+
+  std::fwrite("fmt ", 1, 4, file);
+  writeLe(file, 16, 4);
+  writeLe(file, WAV_FORMAT_FLOAT, 2);
+  writeLe(file, 1, 2); // channels
+  writeLe(file, data.sample_rate, 4);
+  writeLe(file, data.sample_rate * sizeof(float), 4); // byte rate
+  writeLe(file, sizeof(float), 2);                    // block align
+  writeLe(file, 32, 2);                               // bits per sample
+
+  std::fwrite("data", 1, 4, file);
+  writeLe(file, data_size, 4);
+  for (auto sample : data.samples) {
+    std::uint32_t raw;
+    memcpy(&raw, &sample, sizeof(float));
+    writeLe(file, raw, 4);
+  }
+
+  bool ok = !std::ferror(file);
+  std::fclose(file);
+  return ok;
+}
+
+bool readRaw(const std::string& path, AudioData& out) {
+  auto file = path == "-" ? stdin : openFile(path, "rb");
+  if (file == nullptr)
+    return false;
+
+  float chunk[1024];
+  size_t read;
+  while ((read = std::fread(chunk, sizeof(float), 1024, file)) > 0)
+    out.samples.insert(out.samples.end(), chunk, chunk + read);
+
+  bool ok = !std::ferror(file);
+  if (file != stdin)
+    std::fclose(file);
+  return ok;
+}
+
+bool writeRaw(const std::string& path, const AudioData& data) {
+  auto file = path == "-" ? stdout : openFile(path, "wb");
+  if (file == nullptr)
+    return false;
+
+  std::fwrite(data.samples.data(), sizeof(float), data.samples.size(), file);
+
+  bool ok = !std::ferror(file);
+  if (file != stdout)
+    std::fclose(file);
+  else
+    std::fflush(file);
+  return ok;
+}
@@ -0,0 +1,39 @@
+/**
+ * Minimal WAV and raw float stream I/O for the host tools.
+ *
+ * The engine is mono, so multichannel WAV input is mixed down on read and all
+ * output is written as single channel 32 bit float.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AudioData {
+  std::uint32_t sample_rate = 0;
+  std::vector<float> samples;
+};
+
+/**
+ * Reads 16/24/32 bit PCM or 32 bit float WAV data. Returns false and prints
+ * the reason to stderr if the file can't be used.
+ */
+bool readWav(const std::string& path, AudioData& out);
+
+/**
+ * Writes a mono 32 bit float WAV file.
+ */
+bool writeWav(const std::string& path, const AudioData& data);
+
+/**
+ * Reads native endian 32 bit float mono samples until EOF. A path of "-"
+ * reads from stdin.
+ */
+bool readRaw(const std::string& path, AudioData& out);
+
+/**
+ * Writes native endian 32 bit float mono samples. A path of "-" writes to
+ * stdout.
+ */
+bool writeRaw(const std::string& path, const AudioData& data);
@@ -1,17 +1,28 @@
 #include "allocator.hpp"
 #include "daisy_petal.h"
 
-// This is used in the modified CloudSeed code for allocating
-// 61MB delay line memory to SDRAM (64MB available on Daisy)
-#define CUSTOM_POOL_SIZE (61 * 1024 * 1024)
-DSY_SDRAM_BSS char custom_pool[CUSTOM_POOL_SIZE];
-size_t pool_index = 0;
-int allocation_count = 0;
-void* customPoolAllocate(size_t size) {
-  if (pool_index + size >= CUSTOM_POOL_SIZE) {
-    return 0;
+// This is used in the modified CloudSeed code for allocating delay line
+// memory to SDRAM
+DSY_SDRAM_BSS char custom_pool[SDRAM_POOL_SIZE];
+// Left in the default BSS, which is internal RAM
+alignas(ARENA_ALIGNMENT) static char fast_pool[FAST_POOL_SIZE];
+
+// Nothing can be reported from the pedal, and carrying on would write through
+// a null pointer into whatever sits at address 0, so stop where a debugger
+// shows why.
+static void haltOnFailure(const char*, size_t) {
+  while (true) {
   }
-  void* ptr = &custom_pool[pool_index];
-  pool_index += size;
-  return ptr;
-}
\ No newline at end of file
+}
+
+Arena& sdramArena() {
+  // function local, the engine is allocated from static constructors
+  static Arena arena(custom_pool, SDRAM_POOL_SIZE, haltOnFailure);
+  return arena;
+}
+
+Arena& fastArena() {
+  // no failure handler, what does not fit falls back to SDRAM
+  static Arena arena(fast_pool, FAST_POOL_SIZE);
+  return arena;
+}
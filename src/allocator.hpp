@@ -1,15 +1,343 @@
 /**
- * A custom memory allocator for using a section of contiguous SDRAM space.
+ * A custom memory allocator for using a section of contiguous SDRAM space,
+ * and a smaller one of fast internal RAM.
  */
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 
-void* customPoolAllocate(size_t size);
+// Alignment of every allocation: a cache line, which also covers the widest
+// SIMD vector the engine uses
+#ifndef ARENA_ALIGNMENT
+#if defined(__ARM_ARCH_7EM__)
+#define ARENA_ALIGNMENT 32
+#else
+#define ARENA_ALIGNMENT 64
+#endif
+#endif
 
-template <typename T> T* sdramAllocate(std::size_t n) {
-  if (auto p = static_cast<T*>(customPoolAllocate(sizeof(T) * n))) {
-    return p;
+// The SDRAM the firmware hands the arena, 61MB of the Daisy's 64MB
+#define SDRAM_POOL_SIZE (61 * 1024 * 1024)
+// The internal RAM the firmware hands the fast arena
+#define FAST_POOL_SIZE (128 * 1024)
+
+// Allocations recorded for introspection, later ones are still served but
+// only counted under ARENA_UNRECORDED_TAG
+#define ARENA_MAX_RECORDS 256
+#define ARENA_UNRECORDED_TAG "unrecorded"
+
+/**
+ * A bump allocator over one contiguous block of memory.
+ *
+ * Every allocation is aligned to at least ARENA_ALIGNMENT and recorded with a
+ * tag naming what it is for, so the memory use of each part of the engine can
+ * be listed. Nothing is freed on its own: mark() and rewind() release
+ * everything allocated after a point, reset() releases everything, for
+ * re-initialising the engine. An allocation that does not fit returns
+ * nullptr and calls the failure handler, if one is set.
+ */
+class Arena {
+  public:
+  struct Record {
+    const char* tag;
+    size_t offset;
+    size_t bytes;
+  };
+
+  struct TagUsage {
+    const char* tag;
+    size_t bytes;
+    size_t count;
+  };
+
+  /**
+   * Called with the tag and size of an allocation that did not fit.
+   */
+  typedef void (*FailureHandler)(const char* tag, size_t bytes);
+
+  Arena() : Arena(nullptr, 0) {}
+
+  /**
+   * Params:
+   * memory: the block allocations are carved from
+   * capacity: the size of the block in bytes
+   * on_failure: called when an allocation does not fit, may be nullptr
+   */
+  Arena(void* memory, size_t capacity, FailureHandler on_failure = nullptr)
+    : _memory(static_cast<char*>(memory)),
+      _capacity(capacity),
+      _used(0),
+      _high_water(0),
+      _record_count(0),
+      _unrecorded_start(0),
+      _unrecorded_bytes(0),
+      _unrecorded_count(0),
+      _failures(0),
+      _failed_bytes(0),
+      _on_failure(on_failure) {}
+
+  /**
+   * Hands the arena its memory, for arenas whose block is only known once
+   * the program runs. Releases everything allocated so far.
+   */
+  void init(void* memory, size_t capacity) {
+    _memory = static_cast<char*>(memory);
+    _capacity = capacity;
+    _high_water = 0;
+    _failures = 0;
+    _failed_bytes = 0;
+    reset();
+  }
+
+  /**
+   * The memory an allocation of `bytes` takes from an arena, padding
+   * included, for working out ahead of time what a set of allocations needs.
+   */
+  static constexpr size_t footprint(size_t bytes) {
+    return (bytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  }
+
+  void setFailureHandler(FailureHandler handler) {
+    _on_failure = handler;
+  }
+
+  /**
+   * Params:
+   * bytes: the size of the allocation
+   * tag: names what the memory is for, must outlive the arena
+   * alignment: a power of two, at least ARENA_ALIGNMENT is used
+   */
+  void* allocate(size_t bytes,
+                 const char* tag,
+                 size_t alignment = ARENA_ALIGNMENT) {
+    if (alignment < ARENA_ALIGNMENT)
+      alignment = ARENA_ALIGNMENT;
+
+    // aligned as an address, the block itself may not be
+    auto base = reinterpret_cast<std::uintptr_t>(_memory);
+    auto start = ((base + _used + alignment - 1) & ~(alignment - 1)) - base;
+    if (_memory == nullptr || start > _capacity ||
+        bytes > _capacity - start) {
+      _failures++;
+      _failed_bytes += bytes;
+      if (_on_failure != nullptr)
+        _on_failure(tag, bytes);
+      return nullptr;
+    }
+
+    if (_record_count < ARENA_MAX_RECORDS) {
+      _records[_record_count++] = {tag, start, bytes};
+    } else {
+      if (_unrecorded_count == 0)
+        _unrecorded_start = start;
+      _unrecorded_bytes += bytes;
+      _unrecorded_count++;
+    }
+
+    _used = start + bytes;
+    if (_used > _high_water)
+      _high_water = _used;
+    return _memory + start;
+  }
+
+  /**
+   * The point to rewind() to, to release everything allocated after now.
+   */
+  size_t mark() {
+    return _used;
+  }
+
+  /**
+   * Releases everything allocated after `mark`. The memory is left as it
+   * was, callers clear what they reuse.
+   */
+  void rewind(size_t mark) {
+    if (mark >= _used)
+      return;
+
+    _used = mark;
+    while (_record_count > 0 && _records[_record_count - 1].offset >= mark)
+      _record_count--;
+    // the unrecorded allocations are only released all at once
+    if (mark <= _unrecorded_start) {
+      _unrecorded_bytes = 0;
+      _unrecorded_count = 0;
+    }
+  }
+
+  void reset() {
+    rewind(0);
+  }
+
+  size_t capacity() {
+    return _capacity;
+  }
+
+  /**
+   * `pointer` is in this arena's block.
+   */
+  bool owns(const void* pointer) {
+    auto address = static_cast<const char*>(pointer);
+    return _memory != nullptr && address >= _memory &&
+           address < _memory + _capacity;
+  }
+
+  /**
+   * Bytes in use, alignment padding included.
+   */
+  size_t used() {
+    return _used;
+  }
+
+  size_t remaining() {
+    return _capacity - _used;
+  }
+
+  /**
+   * The most bytes ever in use at once since init().
+   */
+  size_t highWaterMark() {
+    return _high_water;
   }
-  return nullptr;
-}
\ No newline at end of file
+
+  /**
+   * Allocations that did not fit since init().
+   */
+  size_t failures() {
+    return _failures;
+  }
+
+  /**
+   * The bytes asked for by the allocations that did not fit since init().
+   */
+  size_t failedBytes() {
+    return _failed_bytes;
+  }
+
+  size_t recordCount() {
+    return _record_count;
+  }
+
+  const Record& record(size_t index) {
+    return _records[index];
+  }
+
+  /**
+   * Sums the live allocations by tag into `usage`, in order of each tag's
+   * first allocation, and returns how many tags there are. Only the first
+   * `max` are written.
+   */
+  size_t usageByTag(TagUsage* usage, size_t max) {
+    size_t tags = 0;
+    auto add = [&](const char* tag, size_t bytes, size_t count) {
+      for (size_t i = 0; i < tags && i < max; i++) {
+        if (std::strcmp(usage[i].tag, tag) == 0) {
+          usage[i].bytes += bytes;
+          usage[i].count += count;
+          return;
+        }
+      }
+      if (tags < max)
+        usage[tags] = {tag, bytes, count};
+      tags++;
+    };
+
+    for (size_t i = 0; i < _record_count; i++)
+      add(_records[i].tag, _records[i].bytes, 1);
+    if (_unrecorded_count > 0)
+      add(ARENA_UNRECORDED_TAG, _unrecorded_bytes, _unrecorded_count);
+    return tags;
+  }
+
+  private:
+  char* _memory;
+  size_t _capacity;
+  size_t _used;
+  size_t _high_water;
+  Record _records[ARENA_MAX_RECORDS];
+  size_t _record_count;
+  // offset of the first allocation past the records
+  size_t _unrecorded_start;
+  size_t _unrecorded_bytes;
+  size_t _unrecorded_count;
+  size_t _failures;
+  size_t _failed_bytes;
+  FailureHandler _on_failure;
+};
+
+/**
+ * Where a buffer is placed. The small buffers touched every sample ask for
+ * the fast internal RAM, the delay memory for the large, slower SDRAM.
+ */
+enum class MemoryTier { Fast = 0, Bulk };
+
+/**
+ * The footprint of an allocation placed in `placed` when planning the memory
+ * of `tier`, see Arena::footprint.
+ */
+constexpr size_t
+tierFootprint(MemoryTier tier, MemoryTier placed, size_t bytes) {
+  return tier == placed ? Arena::footprint(bytes) : 0;
+}
+
+/**
+ * Allocates from `fast` for the fast tier and from `bulk` for the bulk tier,
+ * or when `fast` has no room. The fallbacks are counted by `fast` as
+ * failures, so it must not have a failure handler that stops the program.
+ */
+inline void* placeAllocation(Arena& fast,
+                             Arena& bulk,
+                             size_t bytes,
+                             const char* tag,
+                             MemoryTier tier,
+                             size_t alignment = ARENA_ALIGNMENT) {
+  if (tier == MemoryTier::Fast) {
+    auto memory = fast.allocate(bytes, tag, alignment);
+    if (memory != nullptr)
+      return memory;
+  }
+  return bulk.allocate(bytes, tag, alignment);
+}
+
+/**
+ * The arena the engine's buffers come from. The firmware places it in SDRAM,
+ * the host tools in an mmap'd block, see allocator.cpp and hostallocator.cpp.
+ */
+Arena& sdramArena();
+
+/**
+ * The arena of fast internal RAM. The firmware places it in the default BSS,
+ * the host tools in a block of the same size, so they place buffers the same
+ * way. See allocator.cpp and hostallocator.cpp.
+ */
+Arena& fastArena();
+
+/**
+ * Allocates `n` zero-initialisable `T`s from the SDRAM arena, nullptr if they
+ * do not fit.
+ *
+ * Params:
+ * tag: names what the memory is for in the arena's usage report
+ */
+template <typename T> T* sdramAllocate(std::size_t n, const char* tag) {
+  return static_cast<T*>(
+    sdramArena().allocate(sizeof(T) * n, tag, alignof(T)));
+}
+
+/**
+ * Allocates `n` zero-initialisable `T`s from the fast arena, from the SDRAM
+ * arena if they do not fit there, nullptr if they fit in neither.
+ *
+ * Params:
+ * tag: names what the memory is for in the arenas' usage reports
+ */
+template <typename T> T* fastAllocate(std::size_t n, const char* tag) {
+  return static_cast<T*>(placeAllocation(fastArena(),
+                                         sdramArena(),
+                                         sizeof(T) * n,
+                                         tag,
+                                         MemoryTier::Fast,
+                                         alignof(T)));
+}
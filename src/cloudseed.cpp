@@ -6,6 +6,8 @@
 #include "daisysp.h"
 #include <array>
 
+#include "cloudseed/MemoryPlan.h"
+#include "cloudseed/Profiler.h"
 #include "cloudseed/ReverbController.h"
 #include "constants.h"
 #include "footswitchcontroller.hpp"
@@ -29,6 +31,12 @@ float early_late_mix;
 
 cloudSeed::ReverbController reverb;
 
+// the ticks the control handling and each reverb stage take per callback,
+// read from a debugger
+cloudSeed::Profiler profiler;
+size_t controls_stage;
+size_t dry_mix_stage;
+
 /**
  * Constant power crossfade between two gains
  *
@@ -64,12 +72,16 @@ static void setParameter(std::uint8_t param, float val) {
   }
 }
 
+/**
+ * `out` and `reverb_out` may be the same buffer.
+ */
 static void writeMixedOutput(float* out,
-                             float* dry_in,
+                             const float* dry_in,
                              float* reverb_out,
                              size_t batch_size) {
   for (size_t i = 0; i < batch_size; i++) {
-    out[i] = input_mix.Process(dry_in[i], reverb_out[i]);
+    float dry = dry_in[i];
+    out[i] = input_mix.Process(dry, reverb_out[i]);
   }
 }
 
@@ -83,16 +95,10 @@ static void recallAllPresets() {
   setParameter(EARLY_LATE_MIX, preset_params[EARLY_LATE_MIX]);
 }
 
-// This runs at a fixed rate to prepare audio samples
-static void audioCallback(daisy::AudioHandle::InputBuffer in,
-                          daisy::AudioHandle::OutputBuffer out,
-                          size_t batch_size) {
-  hw.ProcessAnalogControls();
-  hw.ProcessDigitalControls();
-
-  // Benchmarking
-  auto controls_tick_start = hw.seed.system.GetTick();
-
+/**
+ * Reads the footswitches, toggles and knobs and applies what changed.
+ */
+static FootswitchControllerInfo handleControls() {
   auto fsw_info = footswitch_controller.tick();
 
   if (fsw_info.advancePreset) {
@@ -106,13 +112,14 @@ static void audioCallback(daisy::AudioHandle::InputBuffer in,
   }
 
   if (fsw_info.save) {
-    float current_params[PARAMETERS_LENGTH];
+    float current_params[PARAMETERS_LENGTH] = {};
     memcpy(current_params,
            reverb.getAllParameters(),
-           (size_t)cloudSeed::Parameter::Count);
+           (size_t)cloudSeed::Parameter::Count * sizeof(float));
     current_params[INPUT_MIX] = input_mix.GetPos(0.0); // parameter is unused?
     current_params[EARLY_LATE_MIX] = early_late_mix;
 
+    // the maximum of the controls stage shows how much longer saving takes
     preset_controller.save(preset_number, current_params);
   }
 
@@ -127,37 +134,44 @@ static void audioCallback(daisy::AudioHandle::InputBuffer in,
     setParameter(ki.first, ki.second);
   }
 
-  //-- Benchmarking
-  auto controls_time = hw.seed.system.GetTick() - controls_tick_start;
-  if (fsw_info.save) {
-    // set a breakpoint here to see how much longer the saving process takes
-    auto save_control_time = hw.seed.system.GetTick() - controls_tick_start;
-  }
+  return fsw_info;
+}
 
-  auto reverb_tick_start = hw.seed.system.GetTick();
-  //--
+// This runs at a fixed rate to prepare audio samples
+static void audioCallback(daisy::AudioHandle::InputBuffer in,
+                          daisy::AudioHandle::OutputBuffer out,
+                          size_t batch_size) {
+  hw.ProcessAnalogControls();
+  hw.ProcessDigitalControls();
 
-  float mono_input[batch_size];
-  memcpy(mono_input, in[0], batch_size);
+  FootswitchControllerInfo fsw_info;
+  {
+    cloudSeed::ScopedTimer timer(&profiler, controls_stage);
+    fsw_info = handleControls();
+  }
 
-  float mono_reverb_output[batch_size];
+  // the reverb renders straight into the output buffer and is then mixed
+  // with the dry input in place
   if (!fsw_info.bypassed) {
-    reverb.tick(mono_input, mono_reverb_output);
-    writeMixedOutput(out[0], mono_input, mono_reverb_output, batch_size);
-
+    reverb.process(in[0], out[0], batch_size);
+    cloudSeed::ScopedTimer timer(&profiler, dry_mix_stage);
+    writeMixedOutput(out[0], in[0], out[0], batch_size);
   } else {
-    memcpy(out[0], mono_input, batch_size);
+    memcpy(out[0], in[0], batch_size * sizeof(float));
   }
-
-  // Benchmarking
-  auto reverb_time = hw.seed.system.GetTick() - reverb_tick_start;
 }
 
 #ifndef LOCAL
 int main(void) {
   hw.Init();
 
-  audioLib::valueTables::Init();
+  // before the audio callback is started, so it inherits it
+  cloudSeed::utils::enableFlushToZero();
+
+  cloudSeed::profiling::enableCycleCounter();
+  controls_stage = profiler.add("controls");
+  reverb.setProfiler(&profiler);
+  dry_mix_stage = profiler.add("dry_mix");
 
   reverb.clearBuffers();
 
@@ -168,8 +182,11 @@ int main(void) {
   hw.StartAdc();
   hw.StartAudio(audioCallback);
 
+  // the knobs are read in the audio callback, the line settings they derive
+  // are worked out here, off the audio thread
   while (1) {
-    daisy::System::Delay(10);
+    reverb.updateControls();
+    daisy::System::Delay(1);
   }
 }
 #endif
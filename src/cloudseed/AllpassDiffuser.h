@@ -1,15 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 
 #include "../allocator.hpp"
 #include "../constants.h"
+#include "FactorySeeds.h"
 #include "ModulatedAllpass.h"
 #include "Utility/dsp.h"
-#include "audiolib/sharandom.h"
 
 #define MAX_DIFFUSER_STAGE_COUNT 2
 
+static_assert(MAX_DIFFUSER_STAGE_COUNT * 3 == SEED_VALUES_DIFFUSER,
+              "the seed table expands a delay, mod amount and mod rate per "
+              "stage");
+
 #define ALLPASS_DELAY ((int)100) // delay length in ms
 
 namespace cloudSeed {
@@ -17,12 +22,28 @@ class AllpassDiffuser {
   public:
   /**
    * Params:
-   * delay_buffer_length: the maximum delay time, in milliseconds
+   * max_delay: the longest delay of each stage, in samples, longer ones are
+   *            clamped
+   * sample_rate: the sample rate of the program in Hz
+   * block_size: the maximum number of samples processed per tick
+   * lfo: the bank every stage takes a modulator from
+   * format: how the delay memory of every stage is stored
+   * tag: names the stages' memory in the arena's usage report
    */
-  AllpassDiffuser(size_t delay_buffer_length) {
+  AllpassDiffuser(size_t max_delay,
+                  int sample_rate,
+                  size_t block_size,
+                  LfoBank& lfo,
+                  SampleFormat format = SampleFormat::Float32,
+                  const char* tag = "allpass")
+    : _samplerate(sample_rate), _max_delay(max_delay) {
     for (int i = 0; i < MAX_DIFFUSER_STAGE_COUNT; i++) {
-      (void)delay_buffer_length;
-      _filters[i] = new ModulatedAllpass(ALLPASS_DELAY, delay_buffer_length);
+      _filters[i] = new ModulatedAllpass(ALLPASS_DELAY,
+                                         max_delay,
+                                         block_size,
+                                         lfo,
+                                         format,
+                                         tag);
     }
 
     _seed = 23456;
@@ -35,6 +56,24 @@ class AllpassDiffuser {
       delete filter;
   }
 
+  /**
+   * The memory the stages ask of `tier`, see tierFootprint.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier,
+                                     size_t max_delay,
+                                     size_t block_size,
+                                     SampleFormat format) {
+    return MAX_DIFFUSER_STAGE_COUNT *
+           ModulatedAllpass::arenaBytes(tier, max_delay, block_size, format);
+  }
+
+  /**
+   * The heap memory the stages take, allocator overhead aside.
+   */
+  static constexpr size_t heapBytes() {
+    return MAX_DIFFUSER_STAGE_COUNT * sizeof(ModulatedAllpass);
+  }
+
   void setSeed(int seed) {
     _seed = seed;
     updateSeeds();
@@ -54,9 +93,9 @@ class AllpassDiffuser {
       filter->kmodulation_enabled = value;
   }
 
-  void setInterpolationEnabled(bool enabled) {
+  void setInterpolation(Interpolation kernel) {
     for (auto filter : _filters)
-      filter->kinterpolation_enabled = enabled;
+      filter->kinterpolation = kernel;
   }
 
   float* getOutput() {
@@ -84,26 +123,29 @@ class AllpassDiffuser {
     _mod_rate = rate;
 
     for (size_t i = 0; i < _filters.size(); i++)
-      _filters[i]->kmod_rate =
+      _filters[i]->setModRate(
         rate * (0.85 + 0.3 * _seed_values[MAX_DIFFUSER_STAGE_COUNT * 2 + i]) /
-        _samplerate;
+        _samplerate);
   }
 
   void setStages(size_t stages) {
     _stages = stages;
   }
 
-  float* tick(float* input) {
-    _filters[0]->tick(input);
+  float* tick(const float* input, size_t len) {
+    _filters[0]->tick(input, len);
     for (size_t i = 1; i < _stages; i++) {
-      _filters[i]->tick(_filters[i - 1]->getOutput());
+      _filters[i]->tick(_filters[i - 1]->getOutput(), len);
     }
     return getOutput();
   }
 
-  void clearBuffers() {
+  /**
+   * See ModulatedDelay::clearBuffers.
+   */
+  void clearBuffers(BufferClearer* clearer = nullptr) {
     for (auto filter : _filters)
-      filter->clearBuffers();
+      filter->clearBuffers(clearer);
   }
 
   private:
@@ -111,19 +153,18 @@ class AllpassDiffuser {
     for (size_t i = 0; i < _filters.size(); i++) {
       auto r = _seed_values[i];
       auto d = daisysp::pow10f(r) * 0.1; // 0.1 ... 1.0
-      _filters[i]->ksample_delay = (int)(_delay * d);
+      _filters[i]->ksample_delay = std::min((int)(_delay * d), _max_delay);
     }
   }
 
   void updateSeeds() {
-    auto seeds =
-      audioLib::sharandom::generate(_seed, MAX_DIFFUSER_STAGE_COUNT * 3);
-    std::copy(seeds.begin(), seeds.end(), _seed_values);
+    seeds::generate(_seed, _seed_values, MAX_DIFFUSER_STAGE_COUNT * 3);
     update();
   }
 
   private:
   size_t _samplerate;
+  int _max_delay;
   std::array<ModulatedAllpass*, MAX_DIFFUSER_STAGE_COUNT> _filters;
   int _delay;
   float _mod_rate;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Bytes zeroed per sample processed while a clear is pending, 4KB per block
+// on the pedal, well inside its share of the audio callback even in SDRAM
+#define CLEAR_BYTES_PER_SAMPLE 1024
+// The most regions a clear can be queued for at once
+#define CLEAR_QUEUE_LENGTH 32
+
+namespace cloudSeed {
+/**
+ * Zeroes delay memory a slice at a time, so clearing tens of megabytes does
+ * not stall the audio callback. The stages queue their rings with
+ * clearBuffers(&clearer) and the owner calls step() once per block, not
+ * running a stage until its memory is done.
+ *
+ * A region queued again while pending is only cleared once, as long as the
+ * stage it belongs to is not run in between nothing can be written to it.
+ */
+class BufferClearer {
+  public:
+  BufferClearer() : _count(0), _next(0), _offset(0) {}
+
+  /**
+   * Queues `bytes` from `data` on to be zeroed. Should the queue be full the
+   * region is zeroed at once.
+   */
+  void add(void* data, size_t bytes) {
+    auto region = static_cast<char*>(data);
+    for (size_t i = 0; i < _count; i++) {
+      if (_regions[i].data == region)
+        return;
+    }
+
+    if (_count == CLEAR_QUEUE_LENGTH) {
+      memset(region, 0, bytes);
+      return;
+    }
+    _regions[_count++] = {region, bytes};
+  }
+
+  /**
+   * Zeroes up to `budget` bytes of what is queued. Returns whether anything
+   * is left.
+   */
+  bool step(size_t budget) {
+    while (_next < _count && budget > 0) {
+      auto& region = _regions[_next];
+      auto bytes = std::min(budget, region.bytes - _offset);
+      memset(region.data + _offset, 0, bytes);
+      budget -= bytes;
+      _offset += bytes;
+      if (_offset == region.bytes) {
+        _next++;
+        _offset = 0;
+      }
+    }
+
+    if (_next == _count)
+      _count = _next = 0;
+    return isBusy();
+  }
+
+  /**
+   * Zeroes everything queued.
+   */
+  void finish() {
+    while (step(SIZE_MAX)) {
+    }
+  }
+
+  bool isBusy() {
+    return _count > 0;
+  }
+
+  /**
+   * The bytes still to be zeroed.
+   */
+  size_t pendingBytes() {
+    size_t bytes = 0;
+    for (size_t i = _next; i < _count; i++)
+      bytes += _regions[i].bytes;
+    return bytes - _offset;
+  }
+
+  private:
+  struct Region {
+    char* data;
+    size_t bytes;
+  };
+
+  Region _regions[CLEAR_QUEUE_LENGTH];
+  size_t _count;
+  // the region being zeroed and how far it got
+  size_t _next;
+  size_t _offset;
+};
+} // namespace cloudSeed
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "../allocator.hpp"
+#include "BufferClearer.h"
+
+// Full scale of the int16 storage. The loops can run hotter than the input,
+// so samples up to +-4.0 (12dB of headroom) are stored before clipping.
+#define INT16_STORAGE_HEADROOM 4.0f
+
+namespace cloudSeed {
+/**
+ * How a stage keeps its delay memory. The compact formats halve the SDRAM
+ * footprint and bandwidth at the cost of precision, samples are converted on
+ * every write and read.
+ */
+enum class SampleFormat { Float32 = 0, Int16, Float16 };
+
+/**
+ * Sample format of each delay stage. Everything defaults to full precision,
+ * the late stages hold most of the memory and are the ones worth shrinking.
+ */
+struct StorageConfig {
+  SampleFormat pre_delay = SampleFormat::Float32;
+  SampleFormat multitap = SampleFormat::Float32;
+  SampleFormat diffuser = SampleFormat::Float32;
+  SampleFormat line_delay = SampleFormat::Float32;
+  SampleFormat line_diffuser = SampleFormat::Float32;
+};
+
+namespace storage {
+struct Float32 {
+  typedef float sample_t;
+
+  static inline sample_t encode(float value) {
+    return value;
+  }
+
+  static inline float decode(sample_t sample) {
+    return sample;
+  }
+};
+
+struct Int16 {
+  typedef int16_t sample_t;
+
+  static inline sample_t encode(float value) {
+    auto scaled = value * (32767.0f / INT16_STORAGE_HEADROOM);
+    scaled = std::max(-32767.0f, std::min(32767.0f, scaled));
+    // offset to positive so truncation rounds, lrint is a libcall with errno
+    return (sample_t)((int32_t)(scaled + 32768.5f) - 32768);
+  }
+
+  static inline float decode(sample_t sample) {
+    return sample * (INT16_STORAGE_HEADROOM / 32767.0f);
+  }
+};
+
+struct Float16 {
+#if defined(__ARM_FP16_FORMAT_IEEE)
+  // converted by the FPU (VCVTB) on the Cortex-M7
+  typedef __fp16 sample_t;
+
+  static inline sample_t encode(float value) {
+    return value;
+  }
+
+  static inline float decode(sample_t sample) {
+    return sample;
+  }
+#else
+  typedef uint16_t sample_t;
+
+  // round to nearest even, overflow saturates to infinity, subnormals kept
+  static inline sample_t encode(float value) {
+    const uint32_t infinity = 255u << 23;
+    const uint32_t overflow = (127u + 16) << 23;
+    const uint32_t subnormal_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t half;
+    if (bits >= overflow) {
+      half = bits > infinity ? 0x7e00 : 0x7c00;
+    } else if (bits < (113u << 23)) {
+      // let the FPU do the rounding by aligning the mantissa
+      float magic, magnitude;
+      memcpy(&magic, &subnormal_magic, sizeof(magic));
+      memcpy(&magnitude, &bits, sizeof(magnitude));
+      magnitude += magic;
+      memcpy(&bits, &magnitude, sizeof(bits));
+      half = bits - subnormal_magic;
+    } else {
+      uint32_t odd = (bits >> 13) & 1;
+      bits += ((uint32_t)(15 - 127) << 23) + 0xfff + odd;
+      half = bits >> 13;
+    }
+    return half | (sign >> 16);
+  }
+
+  static inline float decode(sample_t sample) {
+    const uint32_t exponent_mask = 0x7c00u << 13;
+    const uint32_t subnormal_magic = 113u << 23;
+
+    uint32_t bits = (sample & 0x7fffu) << 13;
+    uint32_t exponent = bits & exponent_mask;
+    bits += (127u - 15) << 23;
+    if (exponent == exponent_mask) {
+      bits += (128u - 16) << 23; // infinity or NaN
+    } else if (exponent == 0) {
+      float magic, value;
+      bits += 1u << 23;
+      memcpy(&magic, &subnormal_magic, sizeof(magic));
+      memcpy(&value, &bits, sizeof(value));
+      value -= magic;
+      memcpy(&bits, &value, sizeof(bits));
+    }
+    bits |= (uint32_t)(sample & 0x8000u) << 16;
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+#endif
+};
+
+/**
+ * Calls `f` with the codec for `format`, so the stages can pick their
+ * templated inner loop once per block instead of once per sample.
+ */
+template <typename F> inline void dispatch(SampleFormat format, F f) {
+  switch (format) {
+  case SampleFormat::Int16:
+    f(Int16());
+    break;
+  case SampleFormat::Float16:
+    f(Float16());
+    break;
+  default:
+    f(Float32());
+    break;
+  }
+}
+
+constexpr size_t sampleBytes(SampleFormat format) {
+  return format == SampleFormat::Float32 ? sizeof(float) : sizeof(uint16_t);
+}
+} // namespace storage
+
+/**
+ * Ring of delay memory in one of the storage formats, allocated from the SDRAM
+ * arena or, for the short rings, the fast one.
+ *
+ * The length is rounded up to a power of two so indices wrap with a mask
+ * instead of a compare or a division. Indices are unsigned and may be formed
+ * as `write - delay`, the mask takes care of the underflow.
+ *
+ * An optional guard region after the end mirrors the first `guard` samples,
+ * so `guard + 1` consecutive samples can be read from any masked index
+ * without wrapping. Writes that should keep the mirror go through write().
+ */
+class DelayBuffer {
+  public:
+  /**
+   * Params:
+   * samples: the minimum length of the ring in samples
+   * format: how the samples are stored
+   * guard: the number of samples mirrored past the end
+   * tag: names the memory in the arena's usage report
+   * tier: where the memory is placed
+   */
+  DelayBuffer(size_t samples,
+              SampleFormat format,
+              size_t guard = 0,
+              const char* tag = "delay",
+              MemoryTier tier = MemoryTier::Bulk)
+    : _samples(nextPowerOfTwo(samples)), _guard(guard), _format(format) {
+    _mask = _samples - 1;
+    _bytes = bytesFor(samples, format, guard);
+    _data = tier == MemoryTier::Fast ? fastAllocate<char>(_bytes, tag)
+                                     : sdramAllocate<char>(_bytes, tag);
+  }
+
+  /**
+   * The memory a ring of at least `samples` takes, in whole words.
+   */
+  static constexpr size_t
+  bytesFor(size_t samples, SampleFormat format, size_t guard = 0) {
+    return ((nextPowerOfTwo(samples) + guard) * storage::sampleBytes(format) +
+            sizeof(float) - 1) &
+           ~(sizeof(float) - 1);
+  }
+
+  static constexpr size_t nextPowerOfTwo(size_t value) {
+    size_t power = 1;
+    while (power < value)
+      power <<= 1;
+    return power;
+  }
+
+  SampleFormat getFormat() {
+    return _format;
+  }
+
+  size_t size() {
+    return _samples;
+  }
+
+  size_t getMask() {
+    return _mask;
+  }
+
+  size_t getGuard() {
+    return _guard;
+  }
+
+  size_t getBytes() {
+    return _bytes;
+  }
+
+  /**
+   * Where the ring ended up, a ring asking for fast memory falls back to
+   * SDRAM when there is none left.
+   */
+  MemoryTier getTier() {
+    return fastArena().owns(_data) ? MemoryTier::Fast : MemoryTier::Bulk;
+  }
+
+  template <typename Codec> typename Codec::sample_t* data() {
+    return reinterpret_cast<typename Codec::sample_t*>(_data);
+  }
+
+  /**
+   * Stores `value` at the masked `index`, and in the guard region if the
+   * index is mirrored there.
+   */
+  template <typename Codec> inline void write(size_t index, float value) {
+    auto buffer = data<Codec>();
+    auto sample = Codec::encode(value);
+    buffer[index] = sample;
+    if (index < _guard)
+      buffer[_samples + index] = sample;
+  }
+
+  float read(size_t index) {
+    float value = 0;
+    storage::dispatch(_format, [&](auto codec) {
+      typedef decltype(codec) Codec;
+      value = Codec::decode(this->template data<Codec>()[index & _mask]);
+    });
+    return value;
+  }
+
+  /**
+   * Zeroes the ring, or queues it on `clearer` to be zeroed over the next
+   * blocks.
+   */
+  void clear(BufferClearer* clearer = nullptr) {
+    // all zero bits is 0.0 in every format
+    if (clearer)
+      clearer->add(_data, _bytes);
+    else
+      memset(_data, 0, _bytes);
+  }
+
+  private:
+  size_t _samples;
+  size_t _mask;
+  size_t _guard;
+  size_t _bytes;
+  SampleFormat _format;
+  char* _data;
+};
+} // namespace cloudSeed
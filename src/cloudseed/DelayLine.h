@@ -2,60 +2,77 @@
 
 #include "../allocator.hpp"
 #include "../constants.h"
-#include "Filters/tone.h"
-
 #include "AllpassDiffuser.h"
+#include "DelayReach.h"
 #include "ModulatedDelay.h"
-#include "audiolib/biquad.hpp"
-
-// 2 second buffer, to prevent buffer overflow with modulation and randomness
-// added (Which may increase effective delay)
-#define MODULATED_DELAY_BUFFER 2
-
-// 150ms buffer, to allow for 100ms + modulation time
-#define DIFFUSER_BUFFER_LENGTH 150
-
-static float DEFAULT_DELAY_LINE_LOW_PASS_FREQ = 1000.0f;
 
 namespace cloudSeed {
 class DelayLine {
   public:
   bool kdiffuser_enabled;
-  bool klow_shelf_enabled;
-  bool khigh_shelf_enabled;
-  bool kcutoff_enabled;
   bool klate_stage_tap;
   float kfeedback;
 
-  DelayLine()
-    : _delay(MODULATED_DELAY_BUFFER),
-      _diffuser(DIFFUSER_BUFFER_LENGTH),
-      _low_shelf(audioLib::Biquad::FilterType::LowShelf, MCU_CLOCK_RATE),
-      _high_shelf(audioLib::Biquad::FilterType::HighShelf, MCU_CLOCK_RATE) {
-    _temp_buffer = new float[BATCH_SIZE];
-    _mixed_buffer = new float[BATCH_SIZE];
-    _filter_output_buffer = new float[BATCH_SIZE];
-
-    _low_shelf.kslope = 1.0;
-    _low_shelf.setGainDb(-20);
-    _low_shelf.kfrequency = 20;
-
-    _high_shelf.kslope = 1.0;
-    _high_shelf.setGainDb(-20);
-    _high_shelf.kfrequency = 19000;
-
-    _low_pass.Init(MCU_CLOCK_RATE);
-    _low_pass.SetFreq(DEFAULT_DELAY_LINE_LOW_PASS_FREQ);
-    _low_shelf.update();
-    _high_shelf.update();
+  /**
+   * Params:
+   * sample_rate: the sample rate of the program in Hz
+   * block_size: the maximum number of samples processed per tick
+   * lfo: the bank the delay and diffuser modulators come from
+   * delay_format: how the line delay memory is stored
+   * diffuser_format: how the line diffuser memory is stored
+   */
+  DelayLine(int sample_rate,
+            size_t block_size,
+            LfoBank& lfo,
+            SampleFormat delay_format = SampleFormat::Float32,
+            SampleFormat diffuser_format = SampleFormat::Float32)
+    : kdiffuser_enabled(false),
+      klate_stage_tap(false),
+      kfeedback(0),
+      _block_size(block_size),
+      _delay(reach::lineDelay(sample_rate),
+             block_size,
+             lfo,
+             delay_format,
+             "line_delay"),
+      _diffuser(reach::diffuserStage(sample_rate),
+                sample_rate,
+                block_size,
+                lfo,
+                diffuser_format,
+                "line_diffuser") {
+    _mixed_buffer = fastAllocate<float>(_block_size, "line");
+    _feedback_buffer = fastAllocate<float>(_block_size, "line");
+    _feedback_index = 0;
+    _loop_output = _mixed_buffer;
 
     setDiffuserSeed(1);
   }
 
-  ~DelayLine() {
-    delete _temp_buffer;
-    delete _mixed_buffer;
-    delete _filter_output_buffer;
+  /**
+   * The memory a line asks of `tier`, see tierFootprint.
+   */
+  static constexpr size_t
+  arenaBytes(MemoryTier tier,
+             int sample_rate,
+             size_t block_size,
+             SampleFormat delay_format = SampleFormat::Float32,
+             SampleFormat diffuser_format = SampleFormat::Float32) {
+    return ModulatedDelay::arenaBytes(
+             tier, reach::lineDelay(sample_rate), block_size, delay_format) +
+           AllpassDiffuser::arenaBytes(tier,
+                                       reach::diffuserStage(sample_rate),
+                                       block_size,
+                                       diffuser_format) +
+           2 * tierFootprint(
+                 tier, MemoryTier::Fast, block_size * sizeof(float));
+  }
+
+  /**
+   * The heap memory a line takes besides itself, allocator overhead aside.
+   */
+  static constexpr size_t heapBytes() {
+    return AllpassDiffuser::heapBytes();
   }
 
   void setDiffuserSeed(int seed) {
@@ -82,34 +99,12 @@ class DelayLine {
     _diffuser.setStages(stages);
   }
 
-  void setLowShelfGain(float gain) {
-    _low_shelf.setGain(gain);
-  }
-
-  void setLowShelfFrequency(float frequency) {
-    _low_shelf.kfrequency = frequency;
-    _low_shelf.update();
-  }
-
-  void setHighShelfGain(float gain) {
-    _high_shelf.setGain(gain);
-  }
-
-  void setHighShelfFrequency(float frequency) {
-    _high_shelf.kfrequency = frequency;
-    _high_shelf.update();
-  }
-
-  void setCutoffFrequency(float frequency) {
-    _low_pass.SetFreq(frequency);
-  }
-
   void setLineModAmount(float amount) {
     _delay.kmod_amount = amount;
   }
 
   void setLineModRate(float rate) {
-    _delay.kmod_rate = rate;
+    _delay.setModRate(rate);
   }
 
   void setDiffuserModAmount(float amount) {
@@ -121,8 +116,12 @@ class DelayLine {
     _diffuser.setModRate(rate);
   }
 
-  void setInterpolationEnabled(bool value) {
-    _diffuser.setInterpolationEnabled(value);
+  void setDelayInterpolation(Interpolation kernel) {
+    _delay.kinterpolation = kernel;
+  }
+
+  void setDiffuserInterpolation(Interpolation kernel) {
+    _diffuser.setInterpolation(kernel);
   }
 
   float* getOutput() {
@@ -136,63 +135,80 @@ class DelayLine {
     }
   }
 
-  void tick(float* input) {
-    for (int i = 0; i < BATCH_SIZE; i++)
-      _mixed_buffer[i] = input[i] + _filter_output_buffer[i] * kfeedback;
+  /**
+   * Processes `len` samples, at most the block size. The feedback is read
+   * from a one block ring so the loop delay stays the same when a partial
+   * block is processed.
+   */
+  void tick(const float* input, size_t len) {
+    auto fb_index = _feedback_index;
+    for (size_t i = 0; i < len; i++) {
+      _mixed_buffer[i] = input[i] + _feedback_buffer[fb_index] * kfeedback;
+      if (++fb_index == _block_size)
+        fb_index = 0;
+    }
 
     if (klate_stage_tap) {
       if (kdiffuser_enabled) {
-        auto diffuser_out = _diffuser.tick(_mixed_buffer);
-        _delay.tick(diffuser_out);
+        auto diffuser_out = _diffuser.tick(_mixed_buffer, len);
+        _loop_output = _delay.tick(diffuser_out, len);
       } else {
-        _delay.tick(_mixed_buffer);
+        _loop_output = _delay.tick(_mixed_buffer, len);
       }
-
-      memcpy(_temp_buffer, _delay.getOutput(), BATCH_SIZE * sizeof(float));
     } else if (kdiffuser_enabled) {
-      auto delay_out = _delay.tick(_mixed_buffer);
-      auto diffuser_out = _diffuser.tick(delay_out);
-      memcpy(_temp_buffer, diffuser_out, BATCH_SIZE * sizeof(float));
+      auto delay_out = _delay.tick(_mixed_buffer, len);
+      _loop_output = _diffuser.tick(delay_out, len);
     } else {
-      auto delay_out = _delay.tick(_mixed_buffer);
-      memcpy(_temp_buffer, delay_out, BATCH_SIZE * sizeof(float));
+      _loop_output = _delay.tick(_mixed_buffer, len);
     }
+  }
 
-    for (size_t i = 0; i < BATCH_SIZE; i++) {
-      if (klow_shelf_enabled)
-        _low_shelf.tick(_temp_buffer, _temp_buffer, BATCH_SIZE);
-      if (khigh_shelf_enabled)
-        _high_shelf.tick(_temp_buffer, _temp_buffer, BATCH_SIZE);
-      if (kcutoff_enabled) {
-        _temp_buffer[i] = _low_pass.Process(_temp_buffer[i]);
-      }
-    }
+  /**
+   * The unfiltered end of the loop from the last tick, the LineFilterBank
+   * filters it and hands it back through writeFeedback().
+   */
+  const float* getLoopOutput() {
+    return _loop_output;
+  }
 
-    memcpy(_filter_output_buffer, _temp_buffer, BATCH_SIZE * sizeof(float));
+  /**
+   * Appends `len` samples, `stride` floats apart, to the feedback ring.
+   */
+  void writeFeedback(const float* samples, size_t stride, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      _feedback_buffer[_feedback_index] = samples[i * stride];
+      if (++_feedback_index == _block_size)
+        _feedback_index = 0;
+    }
   }
 
-  void clearDiffuserBuffer() {
-    _diffuser.clearBuffers();
+  /**
+   * See ModulatedDelay::clearBuffers, the diffuser must stay disabled until
+   * the clearer is done.
+   */
+  void clearDiffuserBuffer(BufferClearer* clearer = nullptr) {
+    _diffuser.clearBuffers(clearer);
   }
 
-  void clearBuffers() {
-    _delay.clearBuffers();
-    _diffuser.clearBuffers();
-    _low_shelf.clearBuffers();
-    _high_shelf.clearBuffers();
+  /**
+   * See ModulatedDelay::clearBuffers.
+   */
+  void clearBuffers(BufferClearer* clearer = nullptr) {
+    _delay.clearBuffers(clearer);
+    _diffuser.clearBuffers(clearer);
 
-    memset(_temp_buffer, 0.0f, BATCH_SIZE);
-    memset(_filter_output_buffer, 0.0f, BATCH_SIZE);
+    memset(_mixed_buffer, 0, _block_size * sizeof(float));
+    memset(_feedback_buffer, 0, _block_size * sizeof(float));
+    _feedback_index = 0;
   }
 
   private:
+  size_t _block_size;
   ModulatedDelay _delay;
   AllpassDiffuser _diffuser;
-  audioLib::Biquad _low_shelf;
-  audioLib::Biquad _high_shelf;
-  daisysp::Tone _low_pass;
-  float* _temp_buffer;
   float* _mixed_buffer;
-  float* _filter_output_buffer;
+  float* _feedback_buffer;
+  size_t _feedback_index;
+  const float* _loop_output;
 };
 } // namespace cloudSeed
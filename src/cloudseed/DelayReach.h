@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+// The range getScaledParameter maps each time parameter to, in ms
+#define MAX_PRE_DELAY_MS 1000
+#define MAX_TAP_LENGTH_MS 500
+#define MIN_DIFFUSION_DELAY_MS 10
+#define MAX_DIFFUSION_DELAY_MS 100
+#define MIN_LINE_DELAY_MS 20
+#define MAX_LINE_DELAY_MS 1000
+#define MAX_MOD_AMOUNT_MS 2.5
+
+namespace cloudSeed {
+/**
+ * The longest delay each stage can be set to, in samples, given the parameter
+ * ranges above and how far the seeds spread each stage around its parameter.
+ * The stages size their memory from these instead of a fixed time, so nothing
+ * is allocated that the parameters cannot reach.
+ */
+namespace reach {
+constexpr size_t msToSamples(double ms, int sample_rate) {
+  double samples = ms * sample_rate / 1000.0;
+  size_t whole = (size_t)samples;
+  // rounded up, the stages round their delays down
+  return whole < samples ? whole + 1 : whole;
+}
+
+constexpr size_t preDelay(int sample_rate) {
+  return msToSamples(MAX_PRE_DELAY_MS, sample_rate);
+}
+
+/**
+ * The taps are spread over the tap length, which is at least one sample per
+ * tap.
+ */
+constexpr size_t multitap(int sample_rate, size_t max_taps) {
+  size_t samples = msToSamples(MAX_TAP_LENGTH_MS, sample_rate);
+  return samples > max_taps ? samples : max_taps;
+}
+
+/**
+ * Each allpass stage is at most the diffusion delay, its modulation at most
+ * 1.15 times the mod amount.
+ */
+constexpr size_t diffuserStage(int sample_rate) {
+  return msToSamples(MAX_DIFFUSION_DELAY_MS, sample_rate) +
+         msToSamples(MAX_MOD_AMOUNT_MS * 1.15, sample_rate);
+}
+
+/**
+ * Each line is at most 1.5 times the line delay, its modulation at most the
+ * mod amount.
+ */
+constexpr size_t lineDelay(int sample_rate) {
+  return msToSamples(MAX_LINE_DELAY_MS * 1.5, sample_rate) +
+         msToSamples(MAX_MOD_AMOUNT_MS, sample_rate);
+}
+} // namespace reach
+} // namespace cloudSeed
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "../allocator.hpp"
+#include "DelayBuffer.h"
+#include "Interpolation.h"
+
+// Samples the read window of a block may spread past the block and the
+// kernel taps as the modulation moves it, wider windows are read in place
+#define DELAY_STAGING_SLACK 32
+
+// Whether the rings left in SDRAM are staged by default. Off on hosts, where
+// the caches already turn the reads into bursts and the copy only costs.
+#ifndef DELAY_STAGING
+#if defined(__ARM_ARCH_7EM__)
+#define DELAY_STAGING 1
+#else
+#define DELAY_STAGING 0
+#endif
+#endif
+
+namespace cloudSeed {
+/**
+ * Copies the window of a delay ring a block reads into fast scratch memory,
+ * so the kernels read from internal RAM instead of SDRAM.
+ *
+ * The stage plans the window before reading, from the runs of samples it
+ * will read and the whole delay of each, relative to the ring index the
+ * block starts at. fetch() copies the window in one burst, or two where it
+ * wraps, and taps() points the kernels into the copy. A window wider than
+ * the scratch, from deep and fast modulation, is read in place.
+ */
+class DelayStager {
+  public:
+  /**
+   * Params:
+   * block_size: the maximum number of samples processed per tick
+   * format: how the staged ring is stored
+   * tag: names the scratch in the arena's usage report
+   */
+  DelayStager(size_t block_size, SampleFormat format, const char* tag)
+    : _capacity(capacity(block_size)),
+      _enabled(false),
+      _first(0),
+      _last(0) {
+    _scratch =
+      fastAllocate<char>(_capacity * storage::sampleBytes(format), tag);
+  }
+
+  /**
+   * The widest window staged, in samples.
+   */
+  static constexpr size_t capacity(size_t block_size) {
+    return block_size + INTERPOLATION_TAPS + DELAY_STAGING_SLACK;
+  }
+
+  /**
+   * The memory a stager asks of `tier`, see tierFootprint. All of it is fast.
+   */
+  static constexpr size_t
+  arenaBytes(MemoryTier tier, size_t block_size, SampleFormat format) {
+    return tierFootprint(tier,
+                         MemoryTier::Fast,
+                         capacity(block_size) * storage::sampleBytes(format));
+  }
+
+  void setEnabled(bool enabled) {
+    _enabled = enabled;
+  }
+
+  bool isEnabled() {
+    return _enabled;
+  }
+
+  /**
+   * Starts planning the window of a block.
+   */
+  void plan() {
+    _first = PTRDIFF_MAX;
+    _last = PTRDIFF_MIN;
+  }
+
+  /**
+   * Adds `len` samples read from `start` on, `delay` whole samples back, to
+   * the window. `start` is relative to the ring index the block starts at.
+   */
+  void include(ptrdiff_t start, size_t delay, size_t len) {
+    auto first = start - (ptrdiff_t)delay - 2;
+    _first = std::min(_first, first);
+    _last =
+      std::max(_last, first + (ptrdiff_t)(len + INTERPOLATION_TAPS - 1));
+  }
+
+  /**
+   * Copies the planned window out of `ring`, unless staging is off, the
+   * window does not fit, or it reaches past `newest`, where the samples are
+   * only written while the block runs. Returns whether it was staged.
+   *
+   * Params:
+   * index: the ring index the block starts at
+   * newest: the end of the samples in the ring, relative to `index`
+   */
+  template <typename Codec>
+  bool fetch(DelayBuffer& ring, size_t index, ptrdiff_t newest) {
+    if (!_enabled || _last <= _first || _last > newest ||
+        (size_t)(_last - _first) > _capacity)
+      return false;
+
+    typedef typename Codec::sample_t sample_t;
+    auto data = ring.data<Codec>();
+    auto count = (size_t)(_last - _first);
+    auto start = (index + _first) & ring.getMask();
+    auto head = std::min(count, ring.size() - start);
+    memcpy(_scratch, data + start, head * sizeof(sample_t));
+    memcpy(_scratch + head * sizeof(sample_t),
+           data,
+           (count - head) * sizeof(sample_t));
+    return true;
+  }
+
+  /**
+   * The staged taps of the run read from `start` on, `delay` whole samples
+   * back, as FractionalDelay::read() takes them.
+   */
+  template <typename Codec>
+  const typename Codec::sample_t* taps(ptrdiff_t start, size_t delay) {
+    auto staged = reinterpret_cast<const typename Codec::sample_t*>(_scratch);
+    return staged + (start - (ptrdiff_t)delay - 2 - _first);
+  }
+
+  private:
+  size_t _capacity;
+  char* _scratch;
+  bool _enabled;
+  // the window, relative to the ring index the block starts at
+  ptrdiff_t _first;
+  ptrdiff_t _last;
+};
+} // namespace cloudSeed
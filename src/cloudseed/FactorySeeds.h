@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "audiolib/sharandom.h"
+
+// Values expanded for each seed in the table, by the stage that uses it
+#define SEED_VALUES_TAPS 100    // MultitapDiffuser
+#define SEED_VALUES_DIFFUSER 6  // AllpassDiffuser
+#define SEED_VALUES_LINES 15    // LineControl
+#define SEED_VALUES_LFO 18      // LfoBank
+
+namespace cloudSeed {
+namespace seeds {
+struct Entry {
+  long long seed;
+  size_t count;
+};
+
+/**
+ * The seeds of the factory programs and the stage defaults, expanded at
+ * compile time so recalling a program never hashes. The post diffusion seed
+ * of line `i` is the program's seed times `i + 1`. test/seeds.cpp checks the
+ * factory programs against this list.
+ */
+constexpr Entry FACTORY_SEEDS[] = {
+  // TapSeed, 0 is the default
+  {0, SEED_VALUES_TAPS},
+  {114, SEED_VALUES_TAPS},
+  {301, SEED_VALUES_TAPS},
+  {485, SEED_VALUES_TAPS},
+  {1150, SEED_VALUES_TAPS},
+  // DiffusionSeed, then the AllpassDiffuser and DelayLine defaults
+  {156, SEED_VALUES_DIFFUSER},
+  {189, SEED_VALUES_DIFFUSER},
+  {208, SEED_VALUES_DIFFUSER},
+  {23456, SEED_VALUES_DIFFUSER},
+  {1, SEED_VALUES_DIFFUSER},
+  // PostDiffusionSeed of every line
+  {85, SEED_VALUES_DIFFUSER},
+  {170, SEED_VALUES_DIFFUSER},
+  {255, SEED_VALUES_DIFFUSER},
+  {340, SEED_VALUES_DIFFUSER},
+  {425, SEED_VALUES_DIFFUSER},
+  {372, SEED_VALUES_DIFFUSER},
+  {744, SEED_VALUES_DIFFUSER},
+  {1116, SEED_VALUES_DIFFUSER},
+  {1488, SEED_VALUES_DIFFUSER},
+  {1860, SEED_VALUES_DIFFUSER},
+  {501, SEED_VALUES_DIFFUSER},
+  {1002, SEED_VALUES_DIFFUSER},
+  {1503, SEED_VALUES_DIFFUSER},
+  {2004, SEED_VALUES_DIFFUSER},
+  {2505, SEED_VALUES_DIFFUSER},
+  // DelaySeed
+  {161, SEED_VALUES_LINES},
+  {181, SEED_VALUES_LINES},
+  {273, SEED_VALUES_LINES},
+  {335, SEED_VALUES_LINES},
+  {337, SEED_VALUES_LINES},
+  {347, SEED_VALUES_LINES},
+  // CHANNEL_LFO_SEED
+  {8642, SEED_VALUES_LFO},
+};
+
+constexpr size_t FACTORY_SEED_COUNT =
+  sizeof(FACTORY_SEEDS) / sizeof(FACTORY_SEEDS[0]);
+
+constexpr size_t totalValues() {
+  size_t total = 0;
+  for (auto& entry : FACTORY_SEEDS)
+    total += entry.count;
+  return total;
+}
+
+/**
+ * The index of the first entry holding at least `count` values of `seed`,
+ * FACTORY_SEED_COUNT if there is none.
+ */
+constexpr size_t find(long long seed, size_t count) {
+  for (size_t i = 0; i < FACTORY_SEED_COUNT; i++) {
+    if (FACTORY_SEEDS[i].seed == seed && FACTORY_SEEDS[i].count >= count)
+      return i;
+  }
+  return FACTORY_SEED_COUNT;
+}
+
+constexpr bool contains(long long seed, size_t count) {
+  return find(seed, count) < FACTORY_SEED_COUNT;
+}
+
+struct Table {
+  size_t offsets[FACTORY_SEED_COUNT];
+  float values[totalValues()];
+};
+
+constexpr Table expandAll() {
+  Table table{};
+  size_t offset = 0;
+  for (size_t i = 0; i < FACTORY_SEED_COUNT; i++) {
+    table.offsets[i] = offset;
+    audioLib::sharandom::expand(
+      FACTORY_SEEDS[i].seed, table.values + offset, FACTORY_SEEDS[i].count);
+    offset += FACTORY_SEEDS[i].count;
+  }
+  return table;
+}
+
+inline const Table& table() {
+  static constexpr Table expanded = expandAll();
+  return expanded;
+}
+
+/**
+ * Writes `count` values in [0, 1] for `seed` to `out`, from the table when
+ * it holds the seed, otherwise through sharandom. Never allocates.
+ */
+inline void generate(long long seed, float* out, size_t count) {
+  auto i = find(seed, count);
+  if (i == FACTORY_SEED_COUNT) {
+    audioLib::sharandom::generate(seed, out, count);
+    return;
+  }
+
+  auto values = table().values + table().offsets[i];
+  std::copy(values, values + count, out);
+}
+} // namespace seeds
+} // namespace cloudSeed
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "../allocator.hpp"
+
+namespace cloudSeed {
+/**
+ * The FFT of real signals of a fixed power of two size N.
+ *
+ * The signal is packed into a complex one of N/2 points, even samples in the
+ * real part and odd in the imaginary, transformed with an iterative radix-2
+ * FFT and split back into the N/2+1 bins of the real spectrum. Spectra are
+ * kept as separate real and imaginary arrays, so the loops over bins
+ * vectorise. The twiddles and the bit reversal are tabled at construction,
+ * the transforms themselves allocate nothing.
+ */
+class RealFft {
+  public:
+  /**
+   * Params:
+   * size: the number of samples transformed, a power of two of at least 4
+   * tag: names the tables in the arena's usage report
+   */
+  RealFft(size_t size, const char* tag)
+    : _size(size), _half(size / 2), _bits(0) {
+    while (((size_t)1 << (_bits + 1)) < size)
+      _bits++;
+
+    _cos = fastAllocate<float>(_half, tag);
+    _sin = fastAllocate<float>(_half, tag);
+    _reversed = fastAllocate<uint32_t>(_half, tag);
+    for (size_t k = 0; k < _half; k++) {
+      auto angle = 2 * M_PI * k / size;
+      _cos[k] = std::cos(angle);
+      _sin[k] = std::sin(angle);
+
+      uint32_t reversed = 0;
+      for (size_t bit = 0; bit < _bits; bit++)
+        reversed |= ((k >> bit) & 1) << (_bits - 1 - bit);
+      _reversed[k] = reversed;
+    }
+  }
+
+  /**
+   * The memory an FFT of `size` asks of `tier`, see tierFootprint. All of it
+   * is fast.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier, size_t size) {
+    return 2 * tierFootprint(
+                 tier, MemoryTier::Fast, size / 2 * sizeof(float)) +
+           tierFootprint(tier, MemoryTier::Fast, size / 2 * sizeof(uint32_t));
+  }
+
+  size_t getSize() {
+    return _size;
+  }
+
+  /**
+   * The number of bins of a spectrum, N/2+1.
+   */
+  size_t getBins() {
+    return _half + 1;
+  }
+
+  /**
+   * Transforms the N samples of `input` into the bins of `re` and `im`.
+   */
+  void forward(const float* input, float* re, float* im) {
+    for (size_t n = 0; n < _half; n++) {
+      re[_reversed[n]] = input[2 * n];
+      im[_reversed[n]] = input[2 * n + 1];
+    }
+    _transform(re, im, -1);
+
+    // the bins k and N/2-k share their two packed points
+    re[_half] = re[0] - im[0];
+    re[0] += im[0];
+    im[0] = im[_half] = 0;
+    for (size_t k = 1; k <= _half / 2; k++) {
+      auto j = _half - k;
+      auto even_re = 0.5f * (re[k] + re[j]);
+      auto even_im = 0.5f * (im[k] - im[j]);
+      auto odd_re = 0.5f * (im[k] + im[j]);
+      auto odd_im = 0.5f * (re[j] - re[k]);
+      auto c = _cos[k];
+      auto s = _sin[k];
+      auto twiddled_re = c * odd_re + s * odd_im;
+      auto twiddled_im = c * odd_im - s * odd_re;
+
+      re[k] = even_re + twiddled_re;
+      im[k] = even_im + twiddled_im;
+      re[j] = even_re - twiddled_re;
+      im[j] = twiddled_im - even_im;
+    }
+  }
+
+  /**
+   * Transforms the bins of `re` and `im` back into N samples in `output`,
+   * scaled so forward() and inverse() round trip. The bins are overwritten.
+   */
+  void inverse(float* re, float* im, float* output) {
+    {
+      auto even_re = 0.5f * (re[0] + re[_half]);
+      auto even_im = 0.5f * (im[0] - im[_half]);
+      auto odd_re = 0.5f * (re[0] - re[_half]);
+      auto odd_im = 0.5f * (im[0] + im[_half]);
+      re[0] = even_re - odd_im;
+      im[0] = even_im + odd_re;
+    }
+    for (size_t k = 1; k <= _half / 2; k++) {
+      auto j = _half - k;
+      auto even_re = 0.5f * (re[k] + re[j]);
+      auto even_im = 0.5f * (im[k] - im[j]);
+      auto diff_re = 0.5f * (re[k] - re[j]);
+      auto diff_im = 0.5f * (im[k] + im[j]);
+      auto c = _cos[k];
+      auto s = _sin[k];
+      auto odd_re = diff_re * c - diff_im * s;
+      auto odd_im = diff_re * s + diff_im * c;
+
+      re[k] = even_re - odd_im;
+      im[k] = even_im + odd_re;
+      re[j] = even_re + odd_im;
+      im[j] = odd_re - even_im;
+    }
+
+    for (size_t n = 0; n < _half; n++) {
+      auto r = _reversed[n];
+      if (n < r) {
+        std::swap(re[n], re[r]);
+        std::swap(im[n], im[r]);
+      }
+    }
+    _transform(re, im, 1);
+
+    auto scale = 1.0f / _half;
+    for (size_t n = 0; n < _half; n++) {
+      output[2 * n] = re[n] * scale;
+      output[2 * n + 1] = im[n] * scale;
+    }
+  }
+
+  private:
+  size_t _size;
+  size_t _half;
+  size_t _bits;
+  // e^(2 pi i k / N) for k < N/2, the packed transform takes every other one
+  float* _cos;
+  float* _sin;
+  uint32_t* _reversed;
+
+  /**
+   * The N/2 point complex FFT of bit reversed `re` and `im`, in place.
+   * `sign` is the sign of the exponent.
+   */
+  void _transform(float* re, float* im, float sign) {
+    for (size_t span = 2; span <= _half; span *= 2) {
+      auto half = span / 2;
+      auto stride = _size / span;
+      for (size_t start = 0; start < _half; start += span) {
+        for (size_t j = 0; j < half; j++) {
+          auto c = _cos[j * stride];
+          auto s = sign * _sin[j * stride];
+          auto a = start + j;
+          auto b = a + half;
+          auto t_re = re[b] * c - im[b] * s;
+          auto t_im = re[b] * s + im[b] * c;
+          re[b] = re[a] - t_re;
+          im[b] = im[a] - t_im;
+          re[a] += t_re;
+          im[a] += t_im;
+        }
+      }
+    }
+  }
+};
+} // namespace cloudSeed
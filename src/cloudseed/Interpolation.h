@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// Samples a kernel reads around the integer delay, one older and one newer
+// than the linear pair
+#define INTERPOLATION_TAPS 4
+
+namespace cloudSeed {
+/**
+ * How a delay reads between samples when its length is fractional.
+ */
+enum class Interpolation {
+  // rounds the delay down to whole samples
+  None = 0,
+  Linear,
+  // 4 point, 3rd order Catmull-Rom spline
+  Hermite,
+  // 1st order allpass, flat magnitude but a phase delay that only matches
+  // the fraction at low frequencies
+  Allpass,
+};
+
+/**
+ * The interpolation kernel of each modulated stage.
+ */
+struct InterpolationConfig {
+  Interpolation pre_delay = Interpolation::Linear;
+  Interpolation diffuser = Interpolation::Linear;
+  Interpolation line_delay = Interpolation::Linear;
+  Interpolation line_diffuser = Interpolation::Linear;
+};
+
+/**
+ * A fractional delay split into whole samples and the coefficients of the
+ * kernel that reads between them. The coefficients only change when set()
+ * is called, so a run of samples between modulation updates is a short FIR
+ * over contiguous memory.
+ */
+class FractionalDelay {
+  public:
+  FractionalDelay() : _kernel(Interpolation::Linear), _delay(0), _state(0) {
+    set(Interpolation::Linear, 0);
+  }
+
+  /**
+   * The shortest delay `kernel` can read without reaching past the newest
+   * sample.
+   */
+  static size_t minimumDelay(Interpolation kernel) {
+    return kernel == Interpolation::Hermite || kernel == Interpolation::Allpass
+             ? 1
+             : 0;
+  }
+
+  /**
+   * Params:
+   * kernel: the interpolation to use
+   * delay: in samples, at least minimumDelay(kernel)
+   */
+  void set(Interpolation kernel, float delay) {
+    _kernel = kernel;
+    _delay = wholeDelay(kernel, delay);
+    float frac = delay - _delay;
+
+    // the coefficients are for the taps from oldest, `_delay + 2` samples
+    // back, to newest, `_delay - 1` samples back
+    auto c = _coefficients;
+    switch (kernel) {
+    case Interpolation::None:
+      c[0] = 0, c[1] = 0, c[2] = 1, c[3] = 0;
+      break;
+    case Interpolation::Linear:
+      c[0] = 0, c[1] = frac, c[2] = 1 - frac, c[3] = 0;
+      break;
+    case Interpolation::Hermite: {
+      // position between the older and the newer linear tap
+      float t = 1 - frac;
+      float t2 = t * t;
+      float t3 = t2 * t;
+      c[0] = -0.5f * t + t2 - 0.5f * t3;
+      c[1] = 1 - 2.5f * t2 + 1.5f * t3;
+      c[2] = 0.5f * t + 2 * t2 - 1.5f * t3;
+      c[3] = -0.5f * t2 + 0.5f * t3;
+      break;
+    }
+    case Interpolation::Allpass:
+      c[0] = (1 - frac) / (1 + frac), c[1] = 0, c[2] = 0, c[3] = 0;
+      break;
+    }
+  }
+
+  /**
+   * The whole samples of `delay` set() keeps, the kernel reads from
+   * `wholeDelay + 2` samples back.
+   */
+  static size_t wholeDelay(Interpolation kernel, float delay) {
+    size_t whole = (size_t)delay;
+    // the allpass pole sits at -1 for small fractions, keeping the fraction
+    // in [0.5, 1.5) keeps it well damped
+    if (kernel == Interpolation::Allpass && delay - whole < 0.5f && whole > 0)
+      whole--;
+    return whole;
+  }
+
+  Interpolation getKernel() {
+    return _kernel;
+  }
+
+  /**
+   * Whole samples of delay, the fraction is folded into the coefficients.
+   */
+  size_t getDelay() {
+    return _delay;
+  }
+
+  /**
+   * The delay of the newest sample the kernel reads.
+   */
+  size_t getReach() {
+    return _kernel == Interpolation::Hermite ? _delay - 1 : _delay;
+  }
+
+  void clear() {
+    _state = 0;
+  }
+
+  /**
+   * Reads `len` interpolated samples.
+   *
+   * Params:
+   * taps: the oldest of the INTERPOLATION_TAPS samples for the first output,
+   *       which is `getDelay() + 2` samples behind it, followed by at least
+   *       `len + INTERPOLATION_TAPS - 1` contiguous samples
+   * output: where the `len` samples are written
+   */
+  template <typename Codec, typename T>
+  void read(const T* taps, float* output, size_t len) {
+    const float c0 = _coefficients[0];
+    const float c1 = _coefficients[1];
+    const float c2 = _coefficients[2];
+    const float c3 = _coefficients[3];
+
+    switch (_kernel) {
+    case Interpolation::None:
+      for (size_t i = 0; i < len; i++)
+        output[i] = Codec::decode(taps[i + 2]);
+      break;
+    case Interpolation::Linear:
+      for (size_t i = 0; i < len; i++)
+        output[i] = Codec::decode(taps[i + 2]) * c2 +
+                    Codec::decode(taps[i + 1]) * c1;
+      break;
+    case Interpolation::Hermite:
+      for (size_t i = 0; i < len; i++)
+        output[i] =
+          Codec::decode(taps[i]) * c0 + Codec::decode(taps[i + 1]) * c1 +
+          Codec::decode(taps[i + 2]) * c2 + Codec::decode(taps[i + 3]) * c3;
+      break;
+    case Interpolation::Allpass: {
+      // recursive, so this one runs a sample at a time
+      auto state = _state;
+      for (size_t i = 0; i < len; i++) {
+        state = Codec::decode(taps[i + 1]) +
+                c0 * (Codec::decode(taps[i + 2]) - state);
+        output[i] = state;
+      }
+      _state = state;
+      break;
+    }
+    }
+  }
+
+  private:
+  Interpolation _kernel;
+  size_t _delay;
+  float _coefficients[INTERPOLATION_TAPS];
+  // last output of the allpass kernel
+  float _state;
+};
+} // namespace cloudSeed
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "../allocator.hpp"
+#include "FactorySeeds.h"
+
+// Default number of samples between modulation updates
+#define LFO_UPDATE_INTERVAL 8
+
+namespace cloudSeed {
+/**
+ * The sine LFOs of every modulated delay and allpass in a channel.
+ *
+ * Each modulated stage claims a slot. Once per block tick() advances all slots
+ * together, once for every update point that falls in the block, and stores
+ * the values so the stages can pick them up while processing the block. The
+ * slots are kept as flat arrays and the sine is a polynomial, so the update
+ * loop has no table lookups or library calls and vectorises.
+ */
+class LfoBank {
+  public:
+  /**
+   * Params:
+   * capacity: the number of slots
+   * block_size: the maximum number of samples per tick
+   * seed: the starting phases are drawn from this, so a given seed always
+   *       starts the same way
+   */
+  LfoBank(size_t capacity, size_t block_size, long long seed)
+    : _capacity(capacity), _count(0) {
+    _phases = fastAllocate<float>(_capacity, "lfo");
+    _rates = fastAllocate<float>(_capacity, "lfo");
+    _increments = fastAllocate<float>(_capacity, "lfo");
+    // an update interval of 1 has an update point on every sample
+    _values = fastAllocate<float>(_capacity * (block_size + 1), "lfo");
+
+    seeds::generate(seed, _phases, _capacity);
+    for (size_t i = 0; i < _capacity; i++) {
+      _phases[i] = 0.01 + 0.98 * _phases[i];
+      _rates[i] = 0.0;
+    }
+
+    _interval = LFO_UPDATE_INTERVAL;
+    _next_update = _interval;
+    _first_update = _interval;
+    _updateIncrements();
+  }
+
+  /**
+   * The memory a bank asks of `tier`, see tierFootprint. All of it is fast.
+   */
+  static constexpr size_t
+  arenaBytes(MemoryTier tier, size_t capacity, size_t block_size) {
+    return 3 * tierFootprint(tier, MemoryTier::Fast, capacity * sizeof(float)) +
+           tierFootprint(tier,
+                         MemoryTier::Fast,
+                         capacity * (block_size + 1) * sizeof(float));
+  }
+
+  /**
+   * Claims the next slot. The slots are shared out in construction order, so
+   * a channel built the same way always hands every stage the same phase.
+   */
+  size_t add() {
+    auto slot = std::min(_count, _capacity - 1);
+    _count = std::min(_count + 1, _capacity);
+    return slot;
+  }
+
+  /**
+   * Params:
+   * rate: in cycles per sample
+   */
+  void setRate(size_t slot, float rate) {
+    _rates[slot] = rate;
+    _increments[slot] = rate * _interval;
+  }
+
+  void setUpdateInterval(size_t samples) {
+    _interval = std::max((size_t)1, samples);
+    _next_update = std::min(_next_update, _interval);
+    _updateIncrements();
+  }
+
+  size_t getUpdateInterval() {
+    return _interval;
+  }
+
+  /**
+   * The value of a slot at its current phase, for stages to start from.
+   */
+  float getCurrent(size_t slot) {
+    return sine(_phases[slot]);
+  }
+
+  /**
+   * Advances every slot over the next `len` samples.
+   */
+  void tick(size_t len) {
+    _first_update = _next_update;
+
+    float* values = _values;
+    auto offset = _first_update;
+    for (; offset < len; offset += _interval) {
+      for (size_t i = 0; i < _count; i++) {
+        auto phase = _phases[i] + _increments[i];
+        phase -= (int)phase;
+        _phases[i] = phase;
+        values[i] = sine(phase);
+      }
+      values += _capacity;
+    }
+
+    _next_update = offset - len;
+  }
+
+  /**
+   * Advances every slot over the next `len` samples without computing their
+   * values, for blocks no stage runs. The phases step exactly as tick()
+   * steps them, so the modulation carries on as if nothing was skipped.
+   */
+  void skip(size_t len) {
+    auto offset = _next_update;
+    size_t updates = offset < len ? (len - offset - 1) / _interval + 1 : 0;
+    for (size_t i = 0; i < _count; i++) {
+      auto phase = _phases[i];
+      for (size_t update = 0; update < updates; update++) {
+        phase += _increments[i];
+        phase -= (int)phase;
+      }
+      _phases[i] = phase;
+    }
+
+    _next_update = offset + updates * _interval - len;
+  }
+
+  /**
+   * The offset in the current block of its first update point, the rest
+   * follow every getUpdateInterval() samples. May be past the block.
+   */
+  size_t getFirstUpdate() {
+    return _first_update;
+  }
+
+  /**
+   * The value of `slot` at the `update`th update point of the current block.
+   */
+  float getValue(size_t update, size_t slot) {
+    return _values[update * _capacity + slot];
+  }
+
+  /**
+   * sin(2 * pi * phase) for a phase in [0, 1), accurate to about 4e-6.
+   */
+  static inline float sine(float phase) {
+    // fold onto [-0.5, 0.5] half cycles, where sin(pi * x) is a short odd
+    // polynomial, with min/max rather than branches so the loop vectorises
+    float x = 1.0f - 2.0f * phase;
+    float folded = std::max(std::min(x, 1.0f - x), -1.0f - x);
+
+    float x2 = folded * folded;
+    return folded *
+           (3.14159265f +
+            x2 * (-5.16771278f +
+                  x2 * (2.55016404f +
+                        x2 * (-0.59926453f + x2 * 0.08214589f))));
+  }
+
+  private:
+  size_t _capacity;
+  size_t _count;
+  size_t _interval;
+  // offset of the next update point from the start of the next block
+  size_t _next_update;
+  size_t _first_update;
+  float* _phases;
+  float* _rates;
+  float* _increments;
+  float* _values;
+
+  void _updateIncrements() {
+    for (size_t i = 0; i < _capacity; i++)
+      _increments[i] = _rates[i] * _interval;
+  }
+};
+} // namespace cloudSeed
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+#include "../allocator.hpp"
+#include "FactorySeeds.h"
+#include "Utils.h"
+
+namespace cloudSeed {
+/**
+ * The settings of one delay line derived from the line parameters.
+ */
+struct LineSettings {
+  int delay; // in samples
+  float feedback;
+  float mod_amount; // in samples
+  float mod_rate;   // in cycles per sample
+  float diffuser_mod_amount; // in samples
+  float diffuser_mod_rate;   // in Hz
+};
+
+/**
+ * Turns the line parameters into per-line settings at control rate.
+ *
+ * The parameter setters only record the value and can be called from any
+ * thread, including the audio callback. update() does the expensive work,
+ * the seeds and the decay gains, off the audio thread and coalesces however
+ * many changes arrived since it last ran. The result is handed to the audio
+ * thread through a double buffer: update() fills the back buffer and
+ * publishes it, consume() copies it into the lines' front settings and hands
+ * it back. Neither side ever waits, an update that finds the back buffer
+ * still unconsumed is retried on the next call.
+ */
+class LineControl {
+  public:
+  /**
+   * Params:
+   * line_count: the number of lines settings are derived for
+   * sample_rate: the sample rate of the program in Hz
+   */
+  LineControl(size_t line_count, int sample_rate)
+    : _line_count(line_count),
+      _samplerate(sample_rate),
+      _delay(0),
+      _decay(0),
+      _mod_amount(0),
+      _mod_rate(0),
+      _diffuser_mod_amount(0),
+      _diffuser_mod_rate(0),
+      _seed(0),
+      _dirty(false),
+      _published(false) {
+    _seed_values = fastAllocate<float>(_line_count * 3, "line_control");
+    _back = fastAllocate<LineSettings>(_line_count, "line_control");
+    _updateSeeds(0);
+  }
+
+  /**
+   * The memory the settings of `line_count` lines ask of `tier`, see
+   * tierFootprint. All of it is fast.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier, size_t line_count) {
+    return tierFootprint(
+             tier, MemoryTier::Fast, line_count * 3 * sizeof(float)) +
+           tierFootprint(
+             tier, MemoryTier::Fast, line_count * sizeof(LineSettings));
+  }
+
+  /**
+   * Params:
+   * ms: the mean line delay
+   */
+  void setDelay(float ms) {
+    _set(_delay, ms);
+  }
+
+  /**
+   * Params:
+   * seconds: the time the lines take to decay by 60dB
+   */
+  void setDecay(float seconds) {
+    _set(_decay, seconds);
+  }
+
+  void setModAmount(float ms) {
+    _set(_mod_amount, ms);
+  }
+
+  void setModRate(float hz) {
+    _set(_mod_rate, hz);
+  }
+
+  void setDiffuserModAmount(float ms) {
+    _set(_diffuser_mod_amount, ms);
+  }
+
+  void setDiffuserModRate(float hz) {
+    _set(_diffuser_mod_rate, hz);
+  }
+
+  void setSeed(int seed) {
+    _seed.store(seed, std::memory_order_relaxed);
+    _dirty.store(true, std::memory_order_release);
+  }
+
+  /**
+   * Recomputes and publishes the settings if a parameter changed. Runs at
+   * control rate, never on the audio thread and never concurrently with
+   * itself. Returns true if new settings were published.
+   */
+  bool update() {
+    if (_published.load(std::memory_order_acquire) ||
+        !_dirty.exchange(false, std::memory_order_acquire))
+      return false;
+
+    auto load = [](const std::atomic<float>& value) {
+      return value.load(std::memory_order_relaxed);
+    };
+
+    auto seed = _seed.load(std::memory_order_relaxed);
+    if (seed != _seeded)
+      _updateSeeds(seed);
+
+    auto lineDelaySamples = (int)_ms2Samples(load(_delay));
+    auto lineDecaySamples = _ms2Samples(load(_decay) * 1000);
+    auto lineModAmount = _ms2Samples(load(_mod_amount));
+    auto lineModRate = load(_mod_rate);
+    auto lateDiffusionModAmount = _ms2Samples(load(_diffuser_mod_amount));
+    auto lateDiffusionModRate = load(_diffuser_mod_rate);
+
+    for (size_t i = 0; i < _line_count; i++) {
+      auto modAmount =
+        lineModAmount * (0.7 + 0.3 * _seed_values[i + _line_count]);
+      auto modRate = lineModRate *
+                     (0.7 + 0.3 * _seed_values[i + 2 * _line_count]) /
+                     _samplerate;
+
+      auto delaySamples = (0.5 + 1.0 * _seed_values[i]) * lineDelaySamples;
+      // when the delay is set really short,
+      // and the modulation is very high
+      if (delaySamples < modAmount + 2) {
+        // the mod could actually take the delay time negative, prevent
+        // that! -- provide 2 extra sample as margin of safety
+        delaySamples = modAmount + 2;
+      }
+
+      auto dbAfter1Iteration =
+        delaySamples / lineDecaySamples *
+        (-60); // lineDecay is the time it takes to reach T60
+
+      auto& line = _back[i];
+      line.delay = (int)delaySamples;
+      line.feedback = utils::DB2gain(dbAfter1Iteration);
+      line.mod_amount = modAmount;
+      line.mod_rate = modRate;
+      line.diffuser_mod_amount = lateDiffusionModAmount;
+      line.diffuser_mod_rate = lateDiffusionModRate;
+    }
+
+    _published.store(true, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Copies the settings published since the last call into `lines`, which
+   * holds one entry per line. Called from the audio thread, returns false,
+   * leaving `lines` alone, if nothing new was published.
+   */
+  bool consume(LineSettings* lines) {
+    if (!_published.load(std::memory_order_acquire))
+      return false;
+
+    std::copy(_back, _back + _line_count, lines);
+    _published.store(false, std::memory_order_release);
+    return true;
+  }
+
+  private:
+  size_t _line_count;
+  int _samplerate;
+
+  std::atomic<float> _delay;
+  std::atomic<float> _decay;
+  std::atomic<float> _mod_amount;
+  std::atomic<float> _mod_rate;
+  std::atomic<float> _diffuser_mod_amount;
+  std::atomic<float> _diffuser_mod_rate;
+  std::atomic<int> _seed;
+  // a parameter changed since update() last ran
+  std::atomic<bool> _dirty;
+  // the back buffer holds settings the audio thread has not consumed yet
+  std::atomic<bool> _published;
+
+  // only touched by update()
+  int _seeded;
+  float* _seed_values;
+  LineSettings* _back;
+
+  void _set(std::atomic<float>& parameter, float value) {
+    parameter.store(value, std::memory_order_relaxed);
+    _dirty.store(true, std::memory_order_release);
+  }
+
+  void _updateSeeds(int seed) {
+    seeds::generate(seed, _seed_values, _line_count * 3);
+    _seeded = seed;
+  }
+
+  float _ms2Samples(float value) {
+    return value / 1000.0 * _samplerate;
+  }
+};
+} // namespace cloudSeed
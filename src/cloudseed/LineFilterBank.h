@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../allocator.hpp"
+#include "DelayLine.h"
+#include "LineMixing.h"
+#include "audiolib/biquad.hpp"
+
+// Number of delay lines filtered together as the lanes of one vector. The
+// Cortex-M7 on the Daisy has no float SIMD, there every line is its own group
+// so no work is spent on padding lanes.
+#ifndef LINE_LANE_WIDTH
+#if defined(__AVX__)
+#define LINE_LANE_WIDTH 8
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+#define LINE_LANE_WIDTH 4
+#else
+#define LINE_LANE_WIDTH 1
+#endif
+#endif
+
+static float DEFAULT_DELAY_LINE_LOW_PASS_FREQ = 1000.0f;
+
+namespace cloudSeed {
+/**
+ * The shelf and cutoff filters in the feedback path of the late delay lines.
+ *
+ * All lines share the same filter settings, so the coefficients are kept once
+ * and the lines are run as the lanes of a vector, with only the filter state
+ * stored per lane. The samples of a group of lines are interleaved into a
+ * scratch buffer, filtered, and written back into each line's feedback ring.
+ *
+ * The enabled filters run as one cascade of sections in transposed direct
+ * form II, every section applied to a sample before the next sample, so the
+ * block is read and written once and each section keeps two states.
+ *
+ * Unless kmixing is Independent, the filtered lines are then mixed with each
+ * other before they are fed back, see LineMixing.
+ */
+class LineFilterBank {
+  public:
+#if LINE_LANE_WIDTH == 1
+  typedef float lane_t;
+#else
+  // unaligned and allowed to alias float, the lanes live in float buffers.
+  // Spelled out rather than deduced with auto, which drops the alignment.
+  typedef float lane_t
+    __attribute__((vector_size(LINE_LANE_WIDTH * sizeof(float)),
+                   aligned(sizeof(float)),
+                   may_alias));
+#endif
+
+  bool klow_shelf_enabled;
+  bool khigh_shelf_enabled;
+  bool kcutoff_enabled;
+  LineMixing kmixing;
+
+  /**
+   * Params:
+   * line_count: the maximum number of lines filtered per tick
+   * sample_rate: the sample rate of the program in Hz
+   * block_size: the maximum number of samples processed per tick
+   */
+  LineFilterBank(size_t line_count, int sample_rate, size_t block_size)
+    : klow_shelf_enabled(false),
+      khigh_shelf_enabled(false),
+      kcutoff_enabled(false),
+      kmixing(LineMixing::Independent),
+      _samplerate(sample_rate),
+      _block_size(block_size),
+      _group_count((line_count + LINE_LANE_WIDTH - 1) / LINE_LANE_WIDTH),
+      _low_shelf(audioLib::Biquad::FilterType::LowShelf, sample_rate),
+      _high_shelf(audioLib::Biquad::FilterType::HighShelf, sample_rate) {
+    _lane_buffer =
+      fastAllocate<float>(block_size * LINE_LANE_WIDTH, "line_filters");
+    _groups = fastAllocate<Group>(_group_count, "line_filters");
+    _mix_buffer = fastAllocate<float>(line_count * block_size, "line_filters");
+    _mix_scratch = fastAllocate<float>(block_size, "line_filters");
+
+    _low_shelf.kslope = 1.0;
+    _low_shelf.kfrequency = 20;
+    _low_shelf.setGainDb(-20);
+    _updateShelf(_low_shelf, _low_shelf_section);
+
+    _high_shelf.kslope = 1.0;
+    _high_shelf.kfrequency = _belowNyquist(19000);
+    _high_shelf.setGainDb(-20);
+    _updateShelf(_high_shelf, _high_shelf_section);
+
+    setCutoffFrequency(DEFAULT_DELAY_LINE_LOW_PASS_FREQ);
+    clearBuffers();
+  }
+
+  /**
+   * The memory a bank asks of `tier`, see tierFootprint. All of it is fast.
+   */
+  static constexpr size_t
+  arenaBytes(MemoryTier tier, size_t line_count, size_t block_size) {
+    return tierFootprint(tier,
+                         MemoryTier::Fast,
+                         block_size * LINE_LANE_WIDTH * sizeof(float)) +
+           tierFootprint(tier,
+                         MemoryTier::Fast,
+                         (line_count + LINE_LANE_WIDTH - 1) / LINE_LANE_WIDTH *
+                           sizeof(Group)) +
+           tierFootprint(tier,
+                         MemoryTier::Fast,
+                         line_count * block_size * sizeof(float)) +
+           tierFootprint(tier, MemoryTier::Fast, block_size * sizeof(float));
+  }
+
+  void setLowShelfGain(float gain) {
+    _low_shelf.setGain(gain);
+    _updateShelf(_low_shelf, _low_shelf_section);
+  }
+
+  void setLowShelfFrequency(float frequency) {
+    _low_shelf.kfrequency = _belowNyquist(frequency);
+    _low_shelf.update();
+    _updateShelf(_low_shelf, _low_shelf_section);
+  }
+
+  void setHighShelfGain(float gain) {
+    _high_shelf.setGain(gain);
+    _updateShelf(_high_shelf, _high_shelf_section);
+  }
+
+  void setHighShelfFrequency(float frequency) {
+    _high_shelf.kfrequency = _belowNyquist(frequency);
+    _high_shelf.update();
+    _updateShelf(_high_shelf, _high_shelf_section);
+  }
+
+  /**
+   * One pole lowpass, same response as the daisysp::Tone it replaces.
+   */
+  void setCutoffFrequency(float frequency) {
+    auto b = 2.0f - std::cos(2.0f * (float)M_PI * _belowNyquist(frequency) /
+                             _samplerate);
+    _cutoff_feedback = b - std::sqrt(b * b - 1.0f);
+    _cutoff_gain = 1.0f - _cutoff_feedback;
+  }
+
+  /**
+   * Filters the loop output of the first `line_count` lines, mixes them and
+   * writes them to their feedback rings. Called once the lines have ticked
+   * `len` samples.
+   */
+  void tick(DelayLine* const* lines, size_t line_count, size_t len) {
+    // mixed lines are fed back once all of them are filtered
+    bool mixed = kmixing != LineMixing::Independent && line_count > 1;
+
+    _filterLines(
+      line_count,
+      len,
+      [&](size_t k) { return lines[k]->getLoopOutput(); },
+      [&](size_t k, const float* samples, size_t stride) {
+        if (!mixed) {
+          lines[k]->writeFeedback(samples, stride, len);
+          return;
+        }
+        auto line = _mix_buffer + k * _block_size;
+        for (size_t i = 0; i < len; i++)
+          line[i] = samples[i * stride];
+      });
+
+    if (mixed) {
+      mixing::mix(
+        kmixing, _mix_buffer, _block_size, line_count, len, _mix_scratch);
+      for (size_t k = 0; k < line_count; k++)
+        lines[k]->writeFeedback(_mix_buffer + k * _block_size, 1, len);
+    }
+  }
+
+  /**
+   * Filters `len` samples of each of the first `line_count` `inputs` into
+   * `outputs` as tick() filters the lines, with the same state and without
+   * the mixing. For checking the filters on their own.
+   */
+  void filter(const float* const* inputs,
+              float* const* outputs,
+              size_t line_count,
+              size_t len) {
+    _filterLines(
+      line_count,
+      len,
+      [&](size_t k) { return inputs[k]; },
+      [&](size_t k, const float* samples, size_t stride) {
+        for (size_t i = 0; i < len; i++)
+          outputs[k][i] = samples[i * stride];
+      });
+  }
+
+  void clearBuffers() {
+    memset(_groups, 0, _group_count * sizeof(Group));
+  }
+
+  private:
+  struct Section {
+    float b0, b1, b2, a1, a2;
+  };
+
+  struct SectionState {
+    lane_t s1, s2;
+  };
+
+  struct Group {
+    SectionState low_shelf;
+    SectionState high_shelf;
+    lane_t cutoff;
+  };
+
+  struct Shelf {
+    const Section* section;
+    SectionState Group::*state;
+  };
+
+  int _samplerate;
+  size_t _block_size;
+  size_t _group_count;
+  audioLib::Biquad _low_shelf;
+  audioLib::Biquad _high_shelf;
+  Section _low_shelf_section;
+  Section _high_shelf_section;
+  float _cutoff_gain;
+  float _cutoff_feedback;
+  float* _lane_buffer;
+  Group* _groups;
+  // the filtered lines one after another, `_block_size` floats apart
+  float* _mix_buffer;
+  float* _mix_scratch;
+
+  static void _updateShelf(audioLib::Biquad& biquad, Section& section) {
+    auto a = biquad.getA();
+    auto b = biquad.getB();
+    section = {b[0], b[1], b[2], a[1], a[2]};
+  }
+
+  /**
+   * The top of the frequency parameters lies past the Nyquist frequency of
+   * lines running at a lower rate, where the filters would fold over.
+   */
+  float _belowNyquist(float frequency) {
+    return std::min(frequency, 0.49f * _samplerate);
+  }
+
+  /**
+   * Runs the enabled filters over the first `line_count` lines, a group of
+   * lanes at a time. `input(k)` gives the samples of line k, `output(k,
+   * samples, stride)` takes them filtered, every stride-th float.
+   */
+  template <typename Input, typename Output>
+  void _filterLines(size_t line_count,
+                    size_t len,
+                    const Input& input,
+                    const Output& output) {
+    lane_t* lanes = reinterpret_cast<lane_t*>(_lane_buffer);
+
+    // the shelves in the cascade, with the state each uses in a group
+    Shelf shelves[2];
+    size_t shelf_count = 0;
+    if (klow_shelf_enabled)
+      shelves[shelf_count++] = {&_low_shelf_section, &Group::low_shelf};
+    if (khigh_shelf_enabled)
+      shelves[shelf_count++] = {&_high_shelf_section, &Group::high_shelf};
+
+    for (size_t g = 0; g * LINE_LANE_WIDTH < line_count; g++) {
+      auto first = g * LINE_LANE_WIDTH;
+      auto width = std::min((size_t)LINE_LANE_WIDTH, line_count - first);
+      auto& group = _groups[g];
+
+      // interleave, unused lanes stay silent
+      if (width < LINE_LANE_WIDTH)
+        memset(_lane_buffer, 0, len * LINE_LANE_WIDTH * sizeof(float));
+      for (size_t k = 0; k < width; k++) {
+        const float* line_out = input(first + k);
+        for (size_t i = 0; i < len; i++)
+          _lane_buffer[i * LINE_LANE_WIDTH + k] = line_out[i];
+      }
+
+      if (shelf_count == 0 && kcutoff_enabled)
+        _tickCascade<0, true>(shelves, group, lanes, len);
+      else if (shelf_count == 1)
+        kcutoff_enabled ? _tickCascade<1, true>(shelves, group, lanes, len)
+                        : _tickCascade<1, false>(shelves, group, lanes, len);
+      else if (shelf_count == 2)
+        kcutoff_enabled ? _tickCascade<2, true>(shelves, group, lanes, len)
+                        : _tickCascade<2, false>(shelves, group, lanes, len);
+
+      for (size_t k = 0; k < width; k++)
+        output(first + k, _lane_buffer + k, LINE_LANE_WIDTH);
+    }
+  }
+
+  /**
+   * Runs `Shelves` shelf sections and then, if `Cutoff`, the one pole cutoff
+   * over the lanes of `group`, a sample at a time through all of them.
+   */
+  template <size_t Shelves, bool Cutoff>
+  void _tickCascade(const Shelf* shelves,
+                    Group& group,
+                    lane_t* lanes,
+                    size_t len) {
+    Section c[Shelves + 1];
+    lane_t s1[Shelves + 1];
+    lane_t s2[Shelves + 1];
+    for (size_t k = 0; k < Shelves; k++) {
+      c[k] = *shelves[k].section;
+      s1[k] = (group.*shelves[k].state).s1;
+      s2[k] = (group.*shelves[k].state).s2;
+    }
+    lane_t cutoff = group.cutoff;
+
+    for (size_t i = 0; i < len; i++) {
+      lane_t x = lanes[i];
+      for (size_t k = 0; k < Shelves; k++) {
+        lane_t y = c[k].b0 * x + s1[k];
+        s1[k] = c[k].b1 * x - c[k].a1 * y + s2[k];
+        s2[k] = c[k].b2 * x - c[k].a2 * y;
+        x = y;
+      }
+      if (Cutoff) {
+        cutoff = _cutoff_gain * x + _cutoff_feedback * cutoff;
+        x = cutoff;
+      }
+      lanes[i] = x;
+    }
+
+    for (size_t k = 0; k < Shelves; k++) {
+      (group.*shelves[k].state).s1 = s1[k];
+      (group.*shelves[k].state).s2 = s2[k];
+    }
+    group.cutoff = cutoff;
+  }
+};
+} // namespace cloudSeed
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace cloudSeed {
+/**
+ * How the late lines feed back. Mixed through an orthogonal matrix the lines
+ * form a feedback delay network, every echo is spread over all of them on
+ * each pass, which builds echo density much faster than the same number of
+ * independent loops. The matrices preserve energy, so the decay is still set
+ * by the feedback of each line.
+ */
+enum class LineMixing {
+  // every line feeds back into itself, as the original CloudSeed
+  Independent = 0,
+  // x - 2/N * sum(x), for any number of lines
+  Householder,
+  // the fast Walsh-Hadamard transform scaled by 1/sqrt(N). Line counts that
+  // are not a power of two are mixed with the Householder reflection.
+  Hadamard,
+};
+
+namespace mixing {
+/**
+ * Reflects the `count` lines, `len` samples each and `stride` floats apart,
+ * in place, O(N) per sample. `sum` is scratch for `len` floats.
+ */
+inline void householder(
+  float* lines, size_t stride, size_t count, size_t len, float* sum) {
+  for (size_t i = 0; i < len; i++)
+    sum[i] = lines[i];
+  for (size_t k = 1; k < count; k++) {
+    auto line = lines + k * stride;
+    for (size_t i = 0; i < len; i++)
+      sum[i] += line[i];
+  }
+
+  auto scale = 2.0f / count;
+  for (size_t i = 0; i < len; i++)
+    sum[i] *= scale;
+  for (size_t k = 0; k < count; k++) {
+    auto line = lines + k * stride;
+    for (size_t i = 0; i < len; i++)
+      line[i] -= sum[i];
+  }
+}
+
+/**
+ * Transforms the lines, laid out as for householder(), in place, O(N log N)
+ * per sample. `count` must be a power of two.
+ */
+inline void hadamard(float* lines, size_t stride, size_t count, size_t len) {
+  for (size_t half = 1; half < count; half *= 2) {
+    for (size_t k = 0; k < count; k += 2 * half) {
+      for (size_t j = k; j < k + half; j++) {
+        auto a = lines + j * stride;
+        auto b = lines + (j + half) * stride;
+        for (size_t i = 0; i < len; i++) {
+          auto sum = a[i] + b[i];
+          b[i] = a[i] - b[i];
+          a[i] = sum;
+        }
+      }
+    }
+  }
+
+  auto scale = 1.0f / std::sqrt((float)count);
+  for (size_t k = 0; k < count; k++) {
+    auto line = lines + k * stride;
+    for (size_t i = 0; i < len; i++)
+      line[i] *= scale;
+  }
+}
+
+/**
+ * Mixes the lines, laid out as for householder(), with `mixing`. A single
+ * line is left as it is.
+ */
+inline void mix(LineMixing mixing,
+                float* lines,
+                size_t stride,
+                size_t count,
+                size_t len,
+                float* scratch) {
+  if (mixing == LineMixing::Independent || count < 2)
+    return;
+
+  bool power_of_two = (count & (count - 1)) == 0;
+  if (mixing == LineMixing::Hadamard && power_of_two)
+    hadamard(lines, stride, count, len);
+  else
+    householder(lines, stride, count, len, scratch);
+}
+} // namespace mixing
+} // namespace cloudSeed
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+
+#include "../allocator.hpp"
+#include "../constants.h"
+#include "DelayBuffer.h"
+#include "ReverbController.h"
+
+// The internal RAM the engine may take, its objects and the fast arena, the
+// rest of the firmware shares it
+#define SRAM_BUDGET (256 * 1024)
+
+namespace cloudSeed {
+/**
+ * Everything the memory of an engine depends on besides MAX_DELAY_LINES and
+ * the parameter ranges in DelayReach.h.
+ */
+struct EngineConfig {
+  int sample_rate;
+  size_t block_size;
+  StorageConfig storage;
+  LateRate late_rate = LateRate::Full;
+};
+
+/**
+ * What the pedal runs.
+ */
+constexpr EngineConfig FIRMWARE_CONFIG = {
+  MCU_CLOCK_RATE, BATCH_SIZE, StorageConfig()};
+
+/**
+ * The memory an engine takes, worked out from the same sizes its stages
+ * allocate.
+ */
+struct MemoryPlan {
+  // asked of the SDRAM arena, padding included
+  size_t sdram;
+  // asked of the fast arena, what does not fit there falls back to SDRAM
+  size_t fast;
+  // the controller, the stages it allocates on the heap and the arenas'
+  // bookkeeping
+  size_t objects;
+};
+
+constexpr MemoryPlan planMemory(const EngineConfig& config) {
+  return {ReverbController::arenaBytes(MemoryTier::Bulk,
+                                       config.sample_rate,
+                                       config.block_size,
+                                       config.storage,
+                                       config.late_rate),
+          ReverbController::arenaBytes(MemoryTier::Fast,
+                                       config.sample_rate,
+                                       config.block_size,
+                                       config.storage,
+                                       config.late_rate),
+          sizeof(ReverbController) + ReverbController::heapBytes() +
+            2 * sizeof(Arena)};
+}
+} // namespace cloudSeed
+
+// everything may have fallen back to SDRAM
+static_assert(cloudSeed::planMemory(cloudSeed::FIRMWARE_CONFIG).sdram +
+                  cloudSeed::planMemory(cloudSeed::FIRMWARE_CONFIG).fast <=
+                SDRAM_POOL_SIZE,
+              "the engine's delay memory does not fit the SDRAM pool");
+static_assert(cloudSeed::planMemory(cloudSeed::FIRMWARE_CONFIG).objects +
+                  FAST_POOL_SIZE <=
+                SRAM_BUDGET,
+              "the engine does not fit its share of the internal RAM");
@@ -1,158 +1,256 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
-#include <cstdlib>
 #include <cstring>
 
 #include "../allocator.hpp"
 #include "../constants.h"
+#include "DelayBuffer.h"
+#include "DelayStaging.h"
+#include "Interpolation.h"
+#include "LfoBank.h"
 #include "daisy.h"
 
-// Number of samples before updating the modulation
-#define ALLPASS_MODULATION_UPDATE_RATE 8
-
 namespace cloudSeed {
 class ModulatedAllpass {
   public:
   // const int _delay_bufferSamples = 19200; // 100ms at 192Khz
 
   private:
-  float* _delay_buffer;
-  float _output[BATCH_SIZE];
+  size_t _block_size;
+  size_t _max_delay;
+  DelayBuffer _delay_buffer;
+  DelayStager _stager;
+  float* _output;
   size_t _index;
-  unsigned int _samples_processed;
-  size_t _delay_buffer_samples;
-
-  float _mod_phase;
-  int _delay_a;
-  int _delay_b;
-  float _gain_a;
-  float _gain_b;
+  size_t _mask;
+  LfoBank& _lfo;
+  size_t _lfo_slot;
+  FractionalDelay _delay;
 
   public:
   int ksample_delay;
   float kfeedback;
   float kmod_amount;
-  float kmod_rate;
 
-  bool kinterpolation_enabled;
+  Interpolation kinterpolation;
   bool kmodulation_enabled;
 
   /**
    * Params:
-   * sample_delay: in ms
-   * max_sample_delay: in ms
+   * sample_delay: in samples
+   * max_delay: the longest delay the stage is set to, in samples, longer
+   *            ones are clamped
+   * block_size: the maximum number of samples processed per tick
+   * lfo: the bank the modulation is taken from, ticked before this stage
+   * format: how the delay memory is stored
+   * tag: names the stage's memory in the arena's usage report
    */
-  ModulatedAllpass(int sample_delay, size_t max_sample_delay)
-    : ksample_delay(sample_delay) {
-    (void)max_sample_delay;
-    kinterpolation_enabled = true;
-    _delay_buffer_samples = (MCU_CLOCK_RATE / 1000.0) * max_sample_delay;
-    _delay_buffer = sdramAllocate<float>(_delay_buffer_samples);
-
-    _index = _delay_buffer_samples - 1;
-    _mod_phase = 0.01 + 0.98 * std::rand() / (float)RAND_MAX;
-    kmod_rate = 0.0;
+  ModulatedAllpass(int sample_delay,
+                   size_t max_delay,
+                   size_t block_size,
+                   LfoBank& lfo,
+                   SampleFormat format = SampleFormat::Float32,
+                   const char* tag = "allpass")
+    : _block_size(block_size),
+      _max_delay(max_delay),
+      // short and touched every sample, it asks for fast memory
+      _delay_buffer(ringLength(max_delay, block_size),
+                    format,
+                    guard(block_size),
+                    tag,
+                    MemoryTier::Fast),
+      _stager(block_size, format, tag),
+      _lfo(lfo),
+      _lfo_slot(lfo.add()),
+      ksample_delay(sample_delay) {
+    kinterpolation = Interpolation::Linear;
+    kmodulation_enabled = false;
+    _mask = _delay_buffer.getMask();
+    _output = fastAllocate<float>(_block_size, tag);
+    // only a ring that fell back to SDRAM is worth staging
+    setStaging(DELAY_STAGING &&
+               _delay_buffer.getTier() == MemoryTier::Bulk);
+
+    _index = _mask;
     kmod_amount = 0.0;
-    modulate();
+    modulate(_lfo.getCurrent(_lfo_slot));
+  }
+
+  /**
+   * The ring a block can be delayed by up to `max_delay` samples through,
+   * the taps of the kernel and the sample written after the read included.
+   */
+  static constexpr size_t ringLength(size_t max_delay, size_t block_size) {
+    return max_delay + block_size + INTERPOLATION_TAPS + 1;
+  }
+
+  /**
+   * The guard lets a whole block of taps be read without wrapping.
+   */
+  static constexpr size_t guard(size_t block_size) {
+    return block_size + INTERPOLATION_TAPS - 1;
+  }
+
+  static constexpr size_t
+  ringBytes(size_t max_delay, size_t block_size, SampleFormat format) {
+    return DelayBuffer::bytesFor(
+      ringLength(max_delay, block_size), format, guard(block_size));
+  }
+
+  /**
+   * The memory a stage asks of `tier`, see tierFootprint. All of it is fast.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier,
+                                     size_t max_delay,
+                                     size_t block_size,
+                                     SampleFormat format) {
+    return tierFootprint(
+             tier, MemoryTier::Fast, ringBytes(max_delay, block_size, format)) +
+           DelayStager::arenaBytes(tier, block_size, format) +
+           tierFootprint(tier, MemoryTier::Fast, block_size * sizeof(float));
+  }
+
+  /**
+   * See ModulatedDelay::setStaging. Only the samples written before the block
+   * are staged, a delay shorter than the block is read in place.
+   */
+  void setStaging(bool enabled) {
+    _stager.setEnabled(enabled);
+  }
+
+  /**
+   * Params:
+   * rate: in cycles per sample
+   */
+  void setModRate(float rate) {
+    _lfo.setRate(_lfo_slot, rate);
   }
 
   inline float* getOutput() {
     return _output;
   }
 
-  void clearBuffers() {
-    memset(_delay_buffer, 0.0f, _delay_buffer_samples * sizeof(float));
-    memset(_output, 0.0f, BATCH_SIZE * sizeof(float));
+  /**
+   * Resets the stage, zeroing its ring at once or, given a clearer, leaving
+   * that to it. The stage must not run until the clearer is done.
+   */
+  void clearBuffers(BufferClearer* clearer = nullptr) {
+    _delay_buffer.clear(clearer);
+    _delay.clear();
+    memset(_output, 0, _block_size * sizeof(float));
   }
 
-  void tick(float* input) {
-    if (kmodulation_enabled)
-      processWithMod(input);
-    else
-      processNoMod(input);
+  void tick(const float* input, size_t len) {
+    storage::dispatch(_delay_buffer.getFormat(), [&](auto codec) {
+      if (kmodulation_enabled)
+        this->processWithMod(codec, input, len);
+      else
+        this->processNoMod(codec, input, len);
+    });
   }
 
   private:
-  void processNoMod(float* input) {
-    size_t delayed_index = _index - ksample_delay;
-    if (delayed_index < 0)
-      delayed_index += _delay_buffer_samples;
+  template <typename Codec>
+  void processNoMod(Codec, const float* input, size_t len) {
+    auto buffer = _delay_buffer.data<Codec>();
+
+    size_t delayed_index = (_index - ksample_delay) & _mask;
 
-    for (int i = 0; i < BATCH_SIZE; i++) {
-      auto bufOut = _delay_buffer[delayed_index];
+    const typename Codec::sample_t* staged = nullptr;
+    if (_stager.isEnabled()) {
+      _stager.plan();
+      _stager.include(0, ksample_delay, len);
+      if (_stager.fetch<Codec>(_delay_buffer, _index, 0))
+        staged = _stager.taps<Codec>(0, ksample_delay) + 2;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+      auto bufOut = Codec::decode(staged ? staged[i] : buffer[delayed_index]);
       auto inVal = input[i] + bufOut * kfeedback;
 
-      _delay_buffer[_index] = inVal;
+      _delay_buffer.write<Codec>(_index, inVal);
       _output[i] = bufOut - inVal * kfeedback;
 
-      _index++;
-      delayed_index++;
-      if (_index >= _delay_buffer_samples)
-        _index -= _delay_buffer_samples;
-      if (delayed_index >= _delay_buffer_samples)
-        delayed_index -= _delay_buffer_samples;
-      _samples_processed++;
+      _index = (_index + 1) & _mask;
+      delayed_index = (delayed_index + 1) & _mask;
     }
   }
 
-  void processWithMod(float* input) {
-    for (int i = 0; i < BATCH_SIZE; i++) {
-      if (_samples_processed >= ALLPASS_MODULATION_UPDATE_RATE)
-        modulate();
+  /**
+   * Runs between modulation updates are read in one go, as long as every tap
+   * they read was written before the run started, then fed through the
+   * allpass recursion.
+   */
+  template <typename Codec>
+  void processWithMod(Codec, const float* input, size_t len) {
+    auto buffer = _delay_buffer.data<Codec>();
+    bool staged = _stager.isEnabled() && stageReads<Codec>(len);
+    auto next_update = _lfo.getFirstUpdate();
+    size_t update = 0;
+    size_t i = 0;
+
+    while (i < len) {
+      if (i == next_update) {
+        modulate(_lfo.getValue(update++, _lfo_slot));
+        next_update += _lfo.getUpdateInterval();
+      }
 
-      float buf_out;
+      auto end = std::min(std::min(len, next_update), i + _delay.getReach());
+      auto taps = staged ? _stager.taps<Codec>(i, _delay.getDelay())
+                         : buffer + ((_index - _delay.getDelay() - 2) & _mask);
+      _delay.read<Codec>(taps, _output + i, end - i);
 
-      if (kinterpolation_enabled) {
-        int idxA = _index - _delay_a;
-        int idxB = _index - _delay_b;
-        idxA += _delay_buffer_samples * (idxA < 0); // modulo
-        idxB += _delay_buffer_samples * (idxB < 0); // modulo
+      for (; i < end; i++) {
+        auto buf_out = _output[i];
+        auto inVal = input[i] + buf_out * kfeedback;
+        _delay_buffer.write<Codec>(_index, inVal);
+        _output[i] = buf_out - inVal * kfeedback;
 
-        buf_out = _delay_buffer[idxA] * _gain_a + _delay_buffer[idxB] * _gain_b;
-      } else {
-        int idxA = _index - _delay_a;
-        idxA += _delay_buffer_samples * (idxA < 0); // modulo
-        buf_out = _delay_buffer[idxA];
+        _index = (_index + 1) & _mask;
       }
+    }
+  }
 
-      auto inVal = input[i] + buf_out * kfeedback;
-      _delay_buffer[_index] = inVal;
-      _output[i] = buf_out - inVal * kfeedback;
+  /**
+   * Plans the runs the block reads with the delays modulate() is about to
+   * set, and stages their window if it was written before the block.
+   */
+  template <typename Codec> bool stageReads(size_t len) {
+    _stager.plan();
+    auto delay = _delay.getDelay();
+    auto next_update = _lfo.getFirstUpdate();
+    size_t update = 0;
+    size_t i = 0;
+    while (i < len) {
+      if (i == next_update) {
+        auto total = totalDelay(_lfo.getValue(update++, _lfo_slot));
+        delay = FractionalDelay::wholeDelay(kinterpolation, total);
+        next_update += _lfo.getUpdateInterval();
+      }
 
-      _index++;
-      if (_index >= _delay_buffer_samples)
-        _index -= _delay_buffer_samples;
-      _samples_processed++;
+      auto end = std::min(len, next_update);
+      _stager.include(i, delay, end - i);
+      i = end;
     }
+    return _stager.fetch<Codec>(_delay_buffer, _index, 0);
   }
 
   inline float get(int delay) {
-    int idx = _index - delay;
-    if (idx < 0)
-      idx += _delay_buffer_samples;
-
-    return _delay_buffer[idx];
+    return _delay_buffer.read(_index - delay);
   }
 
-  void modulate() {
-    _mod_phase += kmod_rate * ALLPASS_MODULATION_UPDATE_RATE;
-    if (_mod_phase > 1)
-      _mod_phase = std::fmod(_mod_phase, 1.0);
-
-    auto mod = sinf(_mod_phase);
+  float totalDelay(float mod) {
+    // the newest sample is written after the read, so one sample more than
+    // the kernel needs is the shortest delay
     auto total_delay = ksample_delay + kmod_amount * mod;
+    auto min_delay = 1.0f + FractionalDelay::minimumDelay(kinterpolation);
+    return std::min((float)_max_delay, std::max(min_delay, total_delay));
+  }
 
-    // truncate the delay amount to get these two sample locations
-    _delay_a = (int)total_delay;
-    _delay_b = (int)total_delay + 1;
-
-    auto partial = total_delay - _delay_a;
-
-    _gain_a = 1 - partial;
-    _gain_b = partial;
-
-    _samples_processed = 0;
+  void modulate(float mod) {
+    _delay.set(kinterpolation, totalDelay(mod));
   }
 };
 } // namespace cloudSeed
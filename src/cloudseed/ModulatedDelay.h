@@ -2,127 +2,208 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+
 #include "../allocator.hpp"
 #include "../constants.h"
 
+#include "DelayBuffer.h"
+#include "DelayStaging.h"
+#include "Interpolation.h"
+#include "LfoBank.h"
 #include "ModulatedDelay.h"
 #include "Utils.h"
 
-// Number of samples before updating the modulation
-#define DELAY_MODULATION_UPDATE_RATE 8
-
 namespace cloudSeed {
 class ModulatedDelay {
   public:
   int ksample_delay;
 
   float kmod_amount;
-  float kmod_rate;
+  Interpolation kinterpolation;
 
   /**
    * Params:
-   * MCU_CLOCK_RATE: the sample rate of the program in Hz
-   * max_sample_delay: the length of the delay buffer in seconds
+   * max_delay: the longest delay the stage is set to, in samples, longer
+   *            ones are clamped
+   * block_size: the maximum number of samples processed per tick
+   * lfo: the bank the modulation is taken from, ticked before this stage
+   * format: how the delay memory is stored
+   * tag: names the stage's memory in the arena's usage report
    */
-  ModulatedDelay(size_t max_sample_delay) {
-    _delay_buffer_size_samples = MCU_CLOCK_RATE * max_sample_delay;
-    _delay_buffer = sdramAllocate<float>(_delay_buffer_size_samples);
-    _output = sdramAllocate<float>(BATCH_SIZE);
+  ModulatedDelay(size_t max_delay,
+                 size_t block_size,
+                 LfoBank& lfo,
+                 SampleFormat format = SampleFormat::Float32,
+                 const char* tag = "delay")
+    : _block_size(block_size),
+      _max_delay(max_delay),
+      _delay_buffer(
+        ringLength(max_delay, block_size), format, guard(block_size), tag),
+      _stager(block_size, format, tag),
+      _lfo(lfo),
+      _lfo_slot(lfo.add()) {
+    _mask = _delay_buffer.getMask();
+    setStaging(DELAY_STAGING &&
+               _delay_buffer.getTier() == MemoryTier::Bulk);
+    _output = fastAllocate<float>(_block_size, tag);
 
     _write_index = 0;
-    _mod_phase = 0.01 + 0.98 * (std::rand() / (float)RAND_MAX);
 
-    ksample_delay = max_sample_delay;
-    kmod_rate = 0.0;
+    ksample_delay = 0;
     kmod_amount = 0.0;
+    kinterpolation = Interpolation::Linear;
 
-    modulate();
+    modulate(_lfo.getCurrent(_lfo_slot));
   }
 
-  float* getOutput() {
-    return _output;
+  /**
+   * The ring a block can be delayed by up to `max_delay` samples through,
+   * the taps of the kernel included.
+   */
+  static constexpr size_t ringLength(size_t max_delay, size_t block_size) {
+    return max_delay + block_size + INTERPOLATION_TAPS;
   }
 
-  float* tick(float* input) {
-    for (int i = 0; i < BATCH_SIZE; i++) {
-      if (_samples_processed == DELAY_MODULATION_UPDATE_RATE) {
-        modulate();
-        _samples_processed = 0;
-      }
+  /**
+   * The guard lets a whole block of taps be read without wrapping.
+   */
+  static constexpr size_t guard(size_t block_size) {
+    return block_size + INTERPOLATION_TAPS - 1;
+  }
 
-      _write(input[i]);
+  static constexpr size_t
+  ringBytes(size_t max_delay, size_t block_size, SampleFormat format) {
+    return DelayBuffer::bytesFor(
+      ringLength(max_delay, block_size), format, guard(block_size));
+  }
 
-      _output[i] = _read();
+  /**
+   * The memory a stage asks of `tier`, see tierFootprint. The ring is bulk
+   * memory, the output fast.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier,
+                                     size_t max_delay,
+                                     size_t block_size,
+                                     SampleFormat format) {
+    return tierFootprint(
+             tier, MemoryTier::Bulk, ringBytes(max_delay, block_size, format)) +
+           DelayStager::arenaBytes(tier, block_size, format) +
+           tierFootprint(tier, MemoryTier::Fast, block_size * sizeof(float));
+  }
 
-      _samples_processed++;
-    }
+  /**
+   * Turns copying the window each block reads into fast memory first on or
+   * off, see DelayStager. On by default where DELAY_STAGING is and the ring
+   * is in SDRAM.
+   */
+  void setStaging(bool enabled) {
+    _stager.setEnabled(enabled);
+  }
+
+  /**
+   * Params:
+   * rate: in cycles per sample
+   */
+  void setModRate(float rate) {
+    _lfo.setRate(_lfo_slot, rate);
+  }
+
+  float* getOutput() {
+    return _output;
+  }
+
+  float* tick(const float* input, size_t len) {
+    storage::dispatch(_delay_buffer.getFormat(),
+                      [&](auto codec) { this->_tick(codec, input, len); });
     return _output;
   }
 
-  void clearBuffers() {
-    memset(_delay_buffer, 0.0f, _delay_buffer_size_samples);
-    memset(_output, 0.0f, BATCH_SIZE);
+  /**
+   * Resets the stage, zeroing its ring at once or, given a clearer, leaving
+   * that to it. The stage must not run until the clearer is done.
+   */
+  void clearBuffers(BufferClearer* clearer = nullptr) {
+    _delay_buffer.clear(clearer);
+    _delay.clear();
+    memset(_output, 0, _block_size * sizeof(float));
   }
 
   private:
-  float* _delay_buffer;
+  size_t _block_size;
+  size_t _max_delay;
+  DelayBuffer _delay_buffer;
+  DelayStager _stager;
   float* _output;
   size_t _write_index;
-  size_t _read_index_a;
-  size_t _read_index_b;
-  int _samples_processed;
-  size_t _delay_buffer_size_samples;
-
-  float _mod_phase;
-  float _gain_a;
-  float _gain_b;
-
-  void _write(float input) {
-    _delay_buffer[_write_index] = input;
-    _write_index++;
-    if (_write_index >= _delay_buffer_size_samples)
-      _write_index -= _delay_buffer_size_samples;
-  }
+  size_t _mask;
+  LfoBank& _lfo;
+  size_t _lfo_slot;
+  FractionalDelay _delay;
 
-  float _read() {
-    auto output = _delay_buffer[_read_index_a] * _gain_a +
-                  _delay_buffer[_read_index_b] * _gain_a;
+  /**
+   * The block is written first, the delay is then read in runs between the
+   * modulation updates, each with fixed kernel coefficients.
+   */
+  template <typename Codec>
+  void _tick(Codec, const float* input, size_t len) {
+    auto buffer = _delay_buffer.data<Codec>();
+    for (size_t i = 0; i < len; i++)
+      _delay_buffer.write<Codec>((_write_index + i) & _mask, input[i]);
+
+    bool staged = _stager.isEnabled() && stageReads<Codec>(len);
+    auto next_update = _lfo.getFirstUpdate();
+    size_t update = 0;
+    size_t i = 0;
+    while (i < len) {
+      if (i == next_update) {
+        modulate(_lfo.getValue(update++, _lfo_slot));
+        next_update += _lfo.getUpdateInterval();
+      }
 
-    _read_index_a++;
-    _read_index_b++;
-    if (_read_index_a >= _delay_buffer_size_samples)
-      _read_index_a -= _delay_buffer_size_samples;
-    if (_read_index_b >= _delay_buffer_size_samples)
-      _read_index_b -= _delay_buffer_size_samples;
+      auto end = std::min(len, next_update);
+      auto taps =
+        staged ? _stager.taps<Codec>(i, _delay.getDelay())
+               : buffer + ((_write_index + i - _delay.getDelay() - 2) & _mask);
+      _delay.read<Codec>(taps, _output + i, end - i);
+      i = end;
+    }
 
-    return output;
+    _write_index = (_write_index + len) & _mask;
   }
 
-  void modulate() {
-    _mod_phase += kmod_rate * DELAY_MODULATION_UPDATE_RATE;
-    if (_mod_phase > 1)
-      _mod_phase = std::fmod(_mod_phase, 1.0);
-
-    auto mod = sinf(_mod_phase);
-    auto total_delay = ksample_delay + kmod_amount * mod;
-
-    // truncate the delay amount to get these two sample locations
-    auto delay_a = (int)total_delay;
-    auto delay_b = (int)total_delay + 1;
-
-    auto partial = total_delay - delay_a;
+  /**
+   * Plans the runs the block reads with the delays modulate() is about to
+   * set, and stages their window. The block is already written.
+   */
+  template <typename Codec> bool stageReads(size_t len) {
+    _stager.plan();
+    auto delay = _delay.getDelay();
+    auto next_update = _lfo.getFirstUpdate();
+    size_t update = 0;
+    size_t i = 0;
+    while (i < len) {
+      if (i == next_update) {
+        auto total = totalDelay(_lfo.getValue(update++, _lfo_slot));
+        delay = FractionalDelay::wholeDelay(kinterpolation, total);
+        next_update += _lfo.getUpdateInterval();
+      }
 
-    _gain_a = 1 - partial;
-    _gain_b = partial;
+      auto end = std::min(len, next_update);
+      _stager.include(i, delay, end - i);
+      i = end;
+    }
+    return _stager.fetch<Codec>(_delay_buffer, _write_index, len);
+  }
 
-    _read_index_a = _write_index - delay_a;
-    _read_index_b = _write_index - delay_b;
-    if (_read_index_a < 0)
-      _read_index_a += _delay_buffer_size_samples;
-    if (_read_index_b < 0)
-      _read_index_b += _delay_buffer_size_samples;
+  float totalDelay(float mod) {
+    auto total_delay = ksample_delay + kmod_amount * mod;
+    auto min_delay = (float)FractionalDelay::minimumDelay(kinterpolation);
+    return std::min((float)_max_delay, std::max(min_delay, total_delay));
+  }
 
-    _samples_processed = 0;
+  void modulate(float mod) {
+    _delay.set(kinterpolation, totalDelay(mod));
   }
 };
 } // namespace cloudSeed
\ No newline at end of file
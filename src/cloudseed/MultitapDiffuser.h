@@ -5,22 +5,29 @@
 
 #include "../allocator.hpp"
 #include "../constants.h"
+#include "DelayBuffer.h"
+#include "FactorySeeds.h"
 #include "Utils.h"
-#include "audiolib/sharandom.h"
 
 #define MAX_DIFFUSER_TAPS ((size_t)50)
 
+static_assert(MAX_DIFFUSER_TAPS * 2 == SEED_VALUES_TAPS,
+              "the seed table expands a value per tap length and gain");
+
 namespace cloudSeed {
 class MultitapDiffuser {
   private:
-  float* _buffer;
+  size_t _block_size;
+  size_t _max_delay;
+  DelayBuffer _buffer;
   float* _output;
-  size_t _delay_buffer_size;
+  size_t _mask;
 
-  int _buffer_index;
+  size_t _write_index;
 
   float _tap_gains[MAX_DIFFUSER_TAPS];
-  float _tap_positions[MAX_DIFFUSER_TAPS];
+  // in samples behind the newest input, the first tap is the input itself
+  size_t _tap_offsets[MAX_DIFFUSER_TAPS];
   float _tap_lengths[MAX_DIFFUSER_TAPS];
   float _seed_values[MAX_DIFFUSER_TAPS * 2];
 
@@ -32,17 +39,64 @@ class MultitapDiffuser {
   float kdecay;
 
   public:
-  MultitapDiffuser(int delay_buffer_size)
-    : _delay_buffer_size(delay_buffer_size) {
-    _buffer = sdramAllocate<float>(delay_buffer_size);
-    _output = sdramAllocate<float>(BATCH_SIZE);
-
-    _buffer_index = 0;
+  /**
+   * Params:
+   * max_delay: the longest tap length, in samples, longer ones are clamped
+   * block_size: the maximum number of samples processed per tick
+   * format: how the tap buffer is stored
+   */
+  MultitapDiffuser(size_t max_delay,
+                   size_t block_size,
+                   SampleFormat format = SampleFormat::Float32)
+    : _block_size(block_size),
+      _max_delay(max_delay),
+      _buffer(ringLength(max_delay, block_size),
+              format,
+              guard(block_size),
+              "multitap"),
+      _mask(_buffer.getMask()) {
+    _output = fastAllocate<float>(_block_size, "multitap");
+
+    _write_index = 0;
     kgain = 1.0;
     kdecay = 0.0;
+    _seed = 0;
     updateSeeds();
   }
 
+  /**
+   * The ring a block can be tapped `max_delay` samples behind in.
+   */
+  static constexpr size_t ringLength(size_t max_delay, size_t block_size) {
+    return max_delay + block_size;
+  }
+
+  /**
+   * The guard lets every tap read a whole block without wrapping.
+   */
+  static constexpr size_t guard(size_t block_size) {
+    return block_size;
+  }
+
+  static constexpr size_t
+  ringBytes(size_t max_delay, size_t block_size, SampleFormat format) {
+    return DelayBuffer::bytesFor(
+      ringLength(max_delay, block_size), format, guard(block_size));
+  }
+
+  /**
+   * The memory a stage asks of `tier`, see tierFootprint. The ring is bulk
+   * memory, the output fast.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier,
+                                     size_t max_delay,
+                                     size_t block_size,
+                                     SampleFormat format) {
+    return tierFootprint(
+             tier, MemoryTier::Bulk, ringBytes(max_delay, block_size, format)) +
+           tierFootprint(tier, MemoryTier::Fast, block_size * sizeof(float));
+  }
+
   void setSeed(int seed) {
     _seed = seed;
     updateSeeds();
@@ -52,6 +106,22 @@ class MultitapDiffuser {
     return _output;
   }
 
+  size_t getTapCount() {
+    return ktap_count;
+  }
+
+  /**
+   * The taps as tick() sums them, in order, each `getTapOffsets()[j]` samples
+   * behind the input it adds to.
+   */
+  const size_t* getTapOffsets() {
+    return _tap_offsets;
+  }
+
+  const float* getTapGains() {
+    return _tap_gains;
+  }
+
   void setTapCount(int tap_count) {
     ktap_count = (tap_count >= 1) ? tap_count : 1;
     updateTaps();
@@ -72,38 +142,53 @@ class MultitapDiffuser {
     updateTaps();
   }
 
-  float* tick(float* input) {
-    // TODO(baylessj): might be possible to clean up this input buffer
-    // situation, not sure if both the input and output buffers are necessary
-    for (int i = 0; i < BATCH_SIZE; i++) {
-      if (_buffer_index < 0)
-        _buffer_index += _delay_buffer_size;
-      _buffer[_buffer_index] = input[i];
-      _output[i] = 0.0;
-
-      for (size_t j = 0; j < ktap_count; j++) {
-        auto tap_index =
-          (int)fmod(_buffer_index + _tap_positions[j], _delay_buffer_size);
-        _output[i] += _buffer[tap_index] * _tap_gains[j];
-      }
-
-      _buffer_index--;
-    }
+  float* tick(const float* input, size_t len) {
+    storage::dispatch(_buffer.getFormat(),
+                      [&](auto codec) { this->_tick(codec, input, len); });
     return _output;
   }
 
-  void clearBuffers() {
-    memset(_buffer, 0.0f, _delay_buffer_size);
-    memset(_output, 0.0f, _delay_buffer_size);
+  /**
+   * See ModulatedDelay::clearBuffers.
+   */
+  void clearBuffers(BufferClearer* clearer = nullptr) {
+    _buffer.clear(clearer);
+    memset(_output, 0, _block_size * sizeof(float));
   }
 
   private:
+  /**
+   * Tap-major: the block is written first, then each tap adds a contiguous
+   * run of the ring to the output, which the compiler can vectorise.
+   */
+  template <typename Codec>
+  void _tick(Codec, const float* input, size_t len) {
+    auto buffer = _buffer.data<Codec>();
+
+    for (size_t i = 0; i < len; i++)
+      _buffer.write<Codec>((_write_index + i) & _mask, input[i]);
+
+    for (size_t i = 0; i < len; i++)
+      _output[i] = 0.0;
+
+    for (size_t j = 0; j < ktap_count; j++) {
+      auto tap = buffer + ((_write_index - _tap_offsets[j]) & _mask);
+      auto gain = _tap_gains[j];
+      for (size_t i = 0; i < len; i++)
+        _output[i] += Codec::decode(tap[i]) * gain;
+    }
+
+    _write_index = (_write_index + len) & _mask;
+  }
+
   void updateTaps() {
     int s = 0;
     auto rand = [&]() { return _seed_values[s++]; };
 
     if (ktap_length < ktap_count)
       ktap_length = ktap_count;
+    if (ktap_length > _max_delay)
+      ktap_length = _max_delay;
 
     // used to adjust the volume of the overall output as it grows when we add
     // more taps
@@ -119,19 +204,19 @@ class MultitapDiffuser {
     }
 
     auto scale_length = ktap_length / sum_lengths;
-    _tap_positions[0] = 0;
+    _tap_offsets[0] = 0;
     for (size_t i = 1; i < ktap_count; i++) {
       // normalize the randomize tap distance around `ktap_length`
-      _tap_positions[i] =
-        _tap_positions[i - 1] + (int)(_tap_lengths[i] * scale_length);
+      _tap_offsets[i] =
+        _tap_offsets[i - 1] + (size_t)(_tap_lengths[i] * scale_length);
     }
 
-    float last_tap_pos = _tap_positions[ktap_count - 1];
+    float last_tap_pos = _tap_offsets[ktap_count - 1];
     for (size_t i = 0; i < ktap_count; i++) {
       // when decay set to 0, there is no decay, when set to 1, the gain at the
       // last sample is 0.01 = -40dB
       auto g = std::pow(
-        10, -kdecay * 2 * _tap_positions[i] / (float)(last_tap_pos + 1));
+        10, -kdecay * 2 * (float)_tap_offsets[i] / (last_tap_pos + 1));
 
       auto tap = (2 * rand() - 1) * tap_count_factor;
       _tap_gains[i] = tap * g * kgain;
@@ -144,9 +229,7 @@ class MultitapDiffuser {
   void updateSeeds() {
     // generate two sets of seeds, one for the tap lengths, one for the tap
     // gains
-    auto seeds =
-      audioLib::sharandom::generate((long long)_seed, MAX_DIFFUSER_TAPS * 2);
-    std::copy(seeds.begin(), seeds.end(), _seed_values);
+    seeds::generate(_seed, _seed_values, MAX_DIFFUSER_TAPS * 2);
     updateTaps();
   }
 };
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "../allocator.hpp"
+#include "Fft.h"
+
+// Default samples per partition of the convolved response
+#define CONVOLUTION_PARTITION_SIZE 256
+
+namespace cloudSeed {
+/**
+ * Convolves a signal with a fixed impulse response, e.g. one a preset was
+ * frozen into with ReverbController::renderImpulseResponse.
+ *
+ * The response is cut into partitions of B samples. The first is convolved
+ * directly, sample by sample, the rest by uniformly partitioned overlap-save:
+ * every B input samples are transformed once, the spectra of the last blocks
+ * are kept in a frequency domain delay line, multiplied with those of the
+ * partitions and summed, and a single inverse transform gives the next B
+ * samples. The first partition covers the block being collected, so the
+ * output has no latency, and the work per B samples is fixed by the length
+ * of the response alone.
+ */
+class PartitionedConvolver {
+  public:
+  /**
+   * Params:
+   * partition_size: the samples per partition, rounded up to a power of two
+   *                 of at least 4. Larger partitions cost fewer operations
+   *                 but do more direct taps and more work at once.
+   * max_length: the longest response, in samples
+   */
+  PartitionedConvolver(size_t partition_size, size_t max_length)
+    : _partition(partitionSize(partition_size)),
+      _bins(_partition + 1),
+      _max_partitions(partitions(partition_size, max_length)),
+      _partitions(0),
+      _fft(2 * _partition, "convolver"),
+      _position(0),
+      _history_index(0),
+      _filled(0) {
+    auto spectra = _max_partitions * _bins;
+    _response_re = sdramAllocate<float>(spectra, "convolver_spectra");
+    _response_im = sdramAllocate<float>(spectra, "convolver_spectra");
+    _input_re = sdramAllocate<float>(spectra, "convolver_spectra");
+    _input_im = sdramAllocate<float>(spectra, "convolver_spectra");
+
+    _head = fastAllocate<float>(_partition, "convolver");
+    _history = fastAllocate<float>(2 * _partition, "convolver");
+    _window = fastAllocate<float>(2 * _partition, "convolver");
+    _output = fastAllocate<float>(_partition, "convolver");
+    _sum_re = fastAllocate<float>(_bins, "convolver");
+    _sum_im = fastAllocate<float>(_bins, "convolver");
+    _block = fastAllocate<float>(2 * _partition, "convolver");
+
+    setImpulseResponse(nullptr, 0);
+  }
+
+  /**
+   * `partition_size` as it is used.
+   */
+  static constexpr size_t partitionSize(size_t partition_size) {
+    return partition_size <= 4 ? 4
+                               : 2 * partitionSize((partition_size + 1) / 2);
+  }
+
+  /**
+   * The partitions past the first a response of `length` samples takes.
+   */
+  static constexpr size_t partitions(size_t partition_size, size_t length) {
+    return length <= partitionSize(partition_size)
+             ? 0
+             : (length - 1) / partitionSize(partition_size);
+  }
+
+  /**
+   * The memory a convolver asks of `tier`, see tierFootprint. The spectra
+   * are bulk, the rest fast.
+   */
+  static constexpr size_t
+  arenaBytes(MemoryTier tier, size_t partition_size, size_t max_length) {
+    return 4 * tierFootprint(tier,
+                             MemoryTier::Bulk,
+                             partitions(partition_size, max_length) *
+                               (partitionSize(partition_size) + 1) *
+                               sizeof(float)) +
+           _fastBytes(tier, partitionSize(partition_size));
+  }
+
+  size_t getPartitionSize() {
+    return _partition;
+  }
+
+  /**
+   * The partitions past the first the current response takes.
+   */
+  size_t getPartitions() {
+    return _partitions;
+  }
+
+  /**
+   * Sets the response, cut to the longest the convolver was built for, and
+   * clears the state. Transforms every partition, so it is not meant for the
+   * audio callback.
+   */
+  void setImpulseResponse(const float* response, size_t len) {
+    len = std::min(len, (_max_partitions + 1) * _partition);
+    auto head = std::min(len, _partition);
+    std::fill(_head, _head + _partition, 0.0f);
+    std::copy(response, response + head, _head);
+
+    _partitions = partitions(_partition, len);
+    for (size_t p = 0; p < _partitions; p++) {
+      auto start = (p + 1) * _partition;
+      auto count = std::min(len - start, _partition);
+      std::fill(_block, _block + 2 * _partition, 0.0f);
+      std::copy(response + start, response + start + count, _block);
+      _fft.forward(
+        _block, _response_re + p * _bins, _response_im + p * _bins);
+    }
+    reset();
+  }
+
+  /**
+   * Clears the input the convolver still holds.
+   */
+  void reset() {
+    std::fill(_input_re, _input_re + _partitions * _bins, 0.0f);
+    std::fill(_input_im, _input_im + _partitions * _bins, 0.0f);
+    std::fill(_history, _history + 2 * _partition, 0.0f);
+    std::fill(_window, _window + 2 * _partition, 0.0f);
+    std::fill(_output, _output + _partition, 0.0f);
+    _position = 0;
+    _filled = 0;
+    _history_index = 0;
+  }
+
+  /**
+   * Convolves `len` samples, any number. `input` and `output` may be the
+   * same buffer.
+   */
+  void process(const float* input, float* output, size_t len) {
+    while (len > 0) {
+      auto count = std::min(len, _partition - _filled);
+      for (size_t i = 0; i < count; i++) {
+        auto sample = input[i];
+        auto history = _history + _history_index;
+        history[0] = history[_partition] = sample;
+
+        // the tail is the partitions of the previous blocks, B samples late
+        // as the first partition is left out of it
+        float out = _output[_filled + i];
+        for (size_t k = 0; k < _partition; k++)
+          out += _head[k] * history[k];
+        _window[_partition + _filled + i] = sample;
+        output[i] = out;
+
+        _history_index =
+          _history_index == 0 ? _partition - 1 : _history_index - 1;
+      }
+
+      _filled += count;
+      if (_filled == _partition) {
+        _runPartitions();
+        _filled = 0;
+      }
+      input += count;
+      output += count;
+      len -= count;
+    }
+  }
+
+  private:
+  size_t _partition;
+  size_t _bins;
+  size_t _max_partitions;
+  size_t _partitions;
+  RealFft _fft;
+
+  // the spectra of the partitions, and of the input blocks as a ring
+  // starting at _position, newest first
+  float* _response_re;
+  float* _response_im;
+  float* _input_re;
+  float* _input_im;
+  size_t _position;
+
+  float* _head;
+  // the last B input samples twice over, newest first from _history_index,
+  // so the direct taps run over one contiguous span
+  float* _history;
+  size_t _history_index;
+  // the previous block and the one being collected, _filled samples so far
+  float* _window;
+  size_t _filled;
+  float* _output;
+  float* _sum_re;
+  float* _sum_im;
+  float* _block;
+
+  static constexpr size_t _fastBytes(MemoryTier tier, size_t partition) {
+    return RealFft::arenaBytes(tier, 2 * partition) +
+           tierFootprint(tier, MemoryTier::Fast, partition * sizeof(float)) +
+           3 * tierFootprint(
+                 tier, MemoryTier::Fast, 2 * partition * sizeof(float)) +
+           tierFootprint(tier, MemoryTier::Fast, partition * sizeof(float)) +
+           2 * tierFootprint(
+                 tier, MemoryTier::Fast, (partition + 1) * sizeof(float));
+  }
+
+  /**
+   * Runs the block just collected through the partitions.
+   */
+  void _runPartitions() {
+    if (_partitions > 0) {
+      _position = _position == 0 ? _partitions - 1 : _position - 1;
+      _fft.forward(_window,
+                   _input_re + _position * _bins,
+                   _input_im + _position * _bins);
+
+      std::fill(_sum_re, _sum_re + _bins, 0.0f);
+      std::fill(_sum_im, _sum_im + _bins, 0.0f);
+      for (size_t p = 0; p < _partitions; p++) {
+        auto block = (_position + p) % _partitions;
+        auto x_re = _input_re + block * _bins;
+        auto x_im = _input_im + block * _bins;
+        auto h_re = _response_re + p * _bins;
+        auto h_im = _response_im + p * _bins;
+        for (size_t k = 0; k < _bins; k++) {
+          _sum_re[k] += x_re[k] * h_re[k] - x_im[k] * h_im[k];
+          _sum_im[k] += x_re[k] * h_im[k] + x_im[k] * h_re[k];
+        }
+      }
+
+      // overlap-save, the second half is free of the circular wrap
+      _fft.inverse(_sum_re, _sum_im, _block);
+      std::copy(_block + _partition, _block + 2 * _partition, _output);
+    }
+
+    std::copy(_window + _partition, _window + 2 * _partition, _window);
+  }
+};
+} // namespace cloudSeed
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(__ARM_ARCH_7EM__)
+#include <chrono>
+#endif
+
+// Buckets per octave of a histogram, as a power of two. 3 keeps every bucket
+// within 1/8 of the values it holds.
+#define PROFILER_SUB_BUCKET_BITS 3
+// Values below this get a bucket each, above it they share by octave
+#define PROFILER_LINEAR_BUCKETS (2 << PROFILER_SUB_BUCKET_BITS)
+#define PROFILER_BUCKETS                                                       \
+  (PROFILER_LINEAR_BUCKETS +                                                   \
+   (32 - PROFILER_SUB_BUCKET_BITS - 1) * (1 << PROFILER_SUB_BUCKET_BITS))
+// The most stages a profiler holds
+#define PROFILER_MAX_STAGES 20
+
+namespace cloudSeed {
+namespace profiling {
+/**
+ * Starts the cycle counter now() reads. Only the pedal needs it, the host
+ * clocks always run.
+ */
+inline void enableCycleCounter() {
+#if defined(__ARM_ARCH_7EM__)
+  // DEMCR.TRCENA powers the DWT, the lock access register lets it be written
+  *(volatile uint32_t*)0xE000EDFC |= 1 << 24;
+  *(volatile uint32_t*)0xE0001FB0 = 0xC5ACCE55;
+  *(volatile uint32_t*)0xE0001004 = 0;
+  *(volatile uint32_t*)0xE0001000 |= 1;
+#endif
+}
+
+/**
+ * A free running tick count that wraps, only differences of it mean
+ * anything. CPU cycles on the pedal and x86 hosts, nanoseconds elsewhere.
+ */
+inline uint32_t now() {
+#if defined(__ARM_ARCH_7EM__)
+  // DWT_CYCCNT
+  return *(volatile uint32_t*)0xE0001004;
+#elif defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc();
+#else
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+#endif
+}
+} // namespace profiling
+
+/**
+ * The distribution of tick counts, in log spaced buckets of fixed memory so
+ * recording never allocates. Small values are counted exactly, larger ones
+ * by octave split into 2^PROFILER_SUB_BUCKET_BITS buckets each. The minimum,
+ * maximum and sum are kept exactly.
+ */
+class CycleHistogram {
+  public:
+  CycleHistogram() {
+    reset();
+  }
+
+  void reset() {
+    std::memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _min = UINT32_MAX;
+    _max = 0;
+    _sum = 0;
+  }
+
+  void record(uint32_t ticks) {
+    _buckets[bucket(ticks)]++;
+    _count++;
+    _min = ticks < _min ? ticks : _min;
+    _max = ticks > _max ? ticks : _max;
+    _sum += ticks;
+  }
+
+  uint32_t getCount() const {
+    return _count;
+  }
+
+  /**
+   * 0 while nothing was recorded, as are the other statistics.
+   */
+  uint32_t getMin() const {
+    return _count > 0 ? _min : 0;
+  }
+
+  uint32_t getMax() const {
+    return _max;
+  }
+
+  double getMean() const {
+    return _count > 0 ? (double)_sum / _count : 0;
+  }
+
+  /**
+   * The value `fraction` of the recorded ones are at or below, rounded up to
+   * the top of its bucket but never past the maximum.
+   */
+  uint32_t getPercentile(double fraction) const {
+    if (_count == 0)
+      return 0;
+
+    auto rank = (uint64_t)(fraction * _count + 0.999999);
+    rank = rank < 1 ? 1 : rank;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < PROFILER_BUCKETS; b++) {
+      seen += _buckets[b];
+      if (seen >= rank)
+        return upperBound(b) < _max ? upperBound(b) : _max;
+    }
+    return _max;
+  }
+
+  /**
+   * The bucket `ticks` falls in.
+   */
+  static size_t bucket(uint32_t ticks) {
+    if (ticks < PROFILER_LINEAR_BUCKETS)
+      return ticks;
+    auto octave = 31 - __builtin_clz(ticks);
+    auto shift = octave - PROFILER_SUB_BUCKET_BITS;
+    return (shift << PROFILER_SUB_BUCKET_BITS) + (ticks >> shift);
+  }
+
+  /**
+   * The largest value `bucket` holds.
+   */
+  static uint32_t upperBound(size_t bucket) {
+    if (bucket < PROFILER_LINEAR_BUCKETS)
+      return bucket;
+    auto shift = (bucket >> PROFILER_SUB_BUCKET_BITS) - 1;
+    auto top = (bucket & ((1 << PROFILER_SUB_BUCKET_BITS) - 1)) +
+               (1 << PROFILER_SUB_BUCKET_BITS) + 1;
+    return (uint32_t)(((uint64_t)top << shift) - 1);
+  }
+
+  private:
+  uint32_t _buckets[PROFILER_BUCKETS];
+  uint32_t _count;
+  uint32_t _min;
+  uint32_t _max;
+  uint64_t _sum;
+};
+
+/**
+ * Named tick histograms the audio thread records into, e.g. one per stage of
+ * the engine, see ReverbChannel::setProfiler. Stages are added before the
+ * audio starts. The histograms can be read from another thread while it
+ * runs, a read may then miss the block being recorded.
+ */
+class Profiler {
+  public:
+  Profiler() : _stages(0), _reset_requested(false) {}
+
+  /**
+   * Returns the stage named `name`, added if there is none yet, or
+   * PROFILER_MAX_STAGES when the profiler is full, which records nothing.
+   * `name` must outlive the profiler.
+   */
+  size_t add(const char* name) {
+    for (size_t s = 0; s < _stages; s++) {
+      if (std::strcmp(_names[s], name) == 0)
+        return s;
+    }
+    if (_stages == PROFILER_MAX_STAGES)
+      return PROFILER_MAX_STAGES;
+
+    _names[_stages] = name;
+    _histograms[_stages].reset();
+    return _stages++;
+  }
+
+  size_t getStageCount() const {
+    return _stages;
+  }
+
+  const char* getName(size_t stage) const {
+    return _names[stage];
+  }
+
+  const CycleHistogram& getHistogram(size_t stage) const {
+    return _histograms[stage];
+  }
+
+  void record(size_t stage, uint32_t ticks) {
+    if (_reset_requested.load(std::memory_order_relaxed) &&
+        _reset_requested.exchange(false, std::memory_order_acquire)) {
+      for (size_t s = 0; s < _stages; s++)
+        _histograms[s].reset();
+    }
+    if (stage < _stages)
+      _histograms[stage].record(ticks);
+  }
+
+  /**
+   * Empties the histograms before the next tick is recorded, on the thread
+   * recording them.
+   */
+  void requestReset() {
+    _reset_requested.store(true, std::memory_order_release);
+  }
+
+  private:
+  const char* _names[PROFILER_MAX_STAGES];
+  CycleHistogram _histograms[PROFILER_MAX_STAGES];
+  size_t _stages;
+  std::atomic<bool> _reset_requested;
+};
+
+/**
+ * Records the ticks from its construction to the end of its scope into a
+ * stage of `profiler`. Without a profiler the clock is not read.
+ */
+class ScopedTimer {
+  public:
+  ScopedTimer(Profiler* profiler, size_t stage)
+    : _profiler(profiler),
+      _stage(stage),
+      _start(profiler ? profiling::now() : 0) {}
+
+  ~ScopedTimer() {
+    if (_profiler)
+      _profiler->record(_stage, profiling::now() - _start);
+  }
+
+  private:
+  Profiler* _profiler;
+  size_t _stage;
+  uint32_t _start;
+};
+} // namespace cloudSeed
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "../allocator.hpp"
+
+// Taps of each polyphase branch of the resampling filters, the filters are
+// this many low rate samples long whatever the factor
+#define RESAMPLER_TAPS_PER_PHASE 16
+// The passband of the resampling filters as a fraction of the low rate's
+// Nyquist frequency, the rest is the transition band
+#define RESAMPLER_BANDWIDTH 0.9
+
+namespace cloudSeed {
+/**
+ * The rate the late lines run at, as a fraction of the program's. Above a
+ * few kHz the tail is mostly taken out by the line filters anyway, so running
+ * them slower saves most of their work and delay memory.
+ */
+enum class LateRate {
+  Full = 1,
+  Half = 2,
+  Quarter = 4,
+};
+
+namespace resampling {
+/**
+ * The taps of the lowpass both sides of a rate change by `factor` run, a
+ * Blackman windowed sinc with unity gain at DC.
+ */
+inline void design(float* taps, size_t factor) {
+  auto length = factor * RESAMPLER_TAPS_PER_PHASE;
+  auto center = (length - 1) / 2.0;
+  auto cutoff = 0.5 * RESAMPLER_BANDWIDTH / factor;
+
+  double sum = 0;
+  for (size_t t = 0; t < length; t++) {
+    auto x = t - center;
+    auto sinc = std::sin(2 * M_PI * cutoff * x) / (M_PI * x);
+    auto phase = 2 * M_PI * t / (length - 1);
+    auto window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2 * phase);
+    taps[t] = sinc * window;
+    sum += taps[t];
+  }
+  for (size_t t = 0; t < length; t++)
+    taps[t] /= sum;
+}
+
+/**
+ * The delay a decimator and interpolator pair adds, in samples of the high
+ * rate.
+ */
+constexpr size_t delay(size_t factor) {
+  return factor > 1 ? factor * RESAMPLER_TAPS_PER_PHASE - 1 : 0;
+}
+
+/**
+ * The dot product of `len` taps, a multiple of 4, with `samples`. Summed in
+ * four interleaved parts, which the compiler keeps in one vector instead of
+ * waiting on a single sum every tap.
+ */
+inline float dot(const float* taps, const float* samples, size_t len) {
+  float sums[4] = {0, 0, 0, 0};
+  for (size_t t = 0; t < len; t += 4) {
+    for (size_t j = 0; j < 4; j++)
+      sums[j] += taps[t + j] * samples[t + j];
+  }
+  return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+} // namespace resampling
+
+/**
+ * Lowers the rate by `factor`, keeping every factor-th sample of the filtered
+ * signal and only filtering those. Shares its phase with an Interpolator of
+ * the same factor fed from what it puts out, so the low rate samples line up
+ * with the high rate blocks however they are split.
+ */
+class Decimator {
+  public:
+  /**
+   * Params:
+   * factor: 1, 2 or 4, 1 allocates nothing and must not be run
+   * tag: names the memory in the arena's usage report
+   */
+  Decimator(size_t factor, const char* tag)
+    : _factor(factor), _length(_filterLength(factor)), _phase(0), _index(0) {
+    _taps = fastAllocate<float>(_length, tag);
+    _history = fastAllocate<float>(2 * _length, tag);
+    if (_length > 0)
+      resampling::design(_taps, factor);
+    reset();
+  }
+
+  /**
+   * The memory a decimator asks of `tier`, see tierFootprint. All of it is
+   * fast.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier, size_t factor) {
+    return tierFootprint(
+             tier, MemoryTier::Fast, _filterLength(factor) * sizeof(float)) +
+           tierFootprint(tier,
+                         MemoryTier::Fast,
+                         2 * _filterLength(factor) * sizeof(float));
+  }
+
+  /**
+   * The most samples put out for `len` taken in.
+   */
+  static constexpr size_t outputLength(size_t len, size_t factor) {
+    return (len + factor - 1) / factor;
+  }
+
+  void reset() {
+    std::fill(_history, _history + 2 * _length, 0.0f);
+    _phase = 0;
+    _index = 0;
+  }
+
+  /**
+   * Takes `len` samples of `input` and returns how many it put in `output`.
+   */
+  size_t process(const float* input, float* output, size_t len) {
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+      // newest first, twice over so the taps run over one span
+      _history[_index] = _history[_index + _length] = input[i];
+      if (_phase == 0)
+        output[count++] = resampling::dot(_taps, _history + _index, _length);
+      _index = _index == 0 ? _length - 1 : _index - 1;
+      _phase = _phase + 1 == _factor ? 0 : _phase + 1;
+    }
+    return count;
+  }
+
+  /**
+   * Moves on `len` samples of silence without filtering, for when the stage
+   * behind it is skipped. Returns how many samples would have been put out.
+   */
+  size_t skip(size_t len) {
+    auto count = outputLength(len + _phase, _factor) - (_phase > 0 ? 1 : 0);
+    _phase = (_phase + len) % _factor;
+    return count;
+  }
+
+  private:
+  size_t _factor;
+  size_t _length;
+  size_t _phase;
+  size_t _index;
+  float* _taps;
+  float* _history;
+
+  static constexpr size_t _filterLength(size_t factor) {
+    return factor > 1 ? factor * RESAMPLER_TAPS_PER_PHASE : 0;
+  }
+};
+
+/**
+ * Raises the rate by `factor`, filtering the zero stuffed signal one
+ * polyphase branch per output sample so the zeros are never multiplied. See
+ * Decimator.
+ */
+class Interpolator {
+  public:
+  /**
+   * Params:
+   * factor: 1, 2 or 4, 1 allocates nothing and must not be run
+   * tag: names the memory in the arena's usage report
+   */
+  Interpolator(size_t factor, const char* tag)
+    : _factor(factor),
+      _length(factor > 1 ? RESAMPLER_TAPS_PER_PHASE : 0),
+      _phase(0),
+      _index(0) {
+    _branches = fastAllocate<float>(_factor * _length, tag);
+    _history = fastAllocate<float>(2 * _length, tag);
+    if (_length > 0) {
+      resampling::design(_branches, factor);
+      // branch p holds the taps p, p + factor, ..., scaled for the zeros
+      float taps[4 * RESAMPLER_TAPS_PER_PHASE];
+      std::copy(_branches, _branches + _factor * _length, taps);
+      for (size_t p = 0; p < _factor; p++) {
+        for (size_t q = 0; q < _length; q++)
+          _branches[p * _length + q] = _factor * taps[p + q * _factor];
+      }
+    }
+    reset();
+  }
+
+  /**
+   * The memory an interpolator asks of `tier`, see tierFootprint. All of it
+   * is fast.
+   */
+  static constexpr size_t arenaBytes(MemoryTier tier, size_t factor) {
+    return tierFootprint(tier,
+                         MemoryTier::Fast,
+                         (factor > 1 ? factor * RESAMPLER_TAPS_PER_PHASE : 0) *
+                           sizeof(float)) +
+           tierFootprint(tier,
+                         MemoryTier::Fast,
+                         (factor > 1 ? 2 * RESAMPLER_TAPS_PER_PHASE : 0) *
+                           sizeof(float));
+  }
+
+  void reset() {
+    std::fill(_history, _history + 2 * _length, 0.0f);
+    _phase = 0;
+    _index = 0;
+  }
+
+  /**
+   * Puts out `len` samples, taking the next sample of `input` at every
+   * factor-th, as many as the matching Decimator put out for them.
+   */
+  void process(const float* input, float* output, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      if (_phase == 0) {
+        _index = _index == 0 ? _length - 1 : _index - 1;
+        _history[_index] = _history[_index + _length] = *input++;
+      }
+
+      output[i] = resampling::dot(
+        _branches + _phase * _length, _history + _index, _length);
+      _phase = _phase + 1 == _factor ? 0 : _phase + 1;
+    }
+  }
+
+  /**
+   * Moves on `len` samples without output, see Decimator::skip.
+   */
+  void skip(size_t len) {
+    _phase = (_phase + len) % _factor;
+  }
+
+  private:
+  size_t _factor;
+  size_t _length;
+  size_t _phase;
+  size_t _index;
+  float* _branches;
+  float* _history;
+};
+} // namespace cloudSeed
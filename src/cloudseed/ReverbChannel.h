@@ -2,6 +2,7 @@
 #ifndef REVERBCHANNEL
 #define REVERBCHANNEL
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <memory>
@@ -9,20 +10,26 @@
 
 #include "../constants.h"
 #include "AllpassDiffuser.h"
+#include "BufferClearer.h"
+#include "DelayBuffer.h"
 #include "DelayLine.h"
+#include "DelayReach.h"
+#include "FactorySeeds.h"
 #include "Filters/atone.h"
 #include "Filters/tone.h"
+#include "Interpolation.h"
+#include "LfoBank.h"
+#include "LineControl.h"
+#include "LineFilterBank.h"
+#include "LineMixing.h"
 #include "ModulatedDelay.h"
 #include "MultitapDiffuser.h"
 #include "Parameter.h"
+#include "Profiler.h"
+#include "Resampler.h"
 #include "ReverbChannel.h"
+#include "SilenceTracker.h"
 #include "Utils.h"
-#include "audiolib/sharandom.h"
-
-#define PRE_DELAY_BUFFER_LENGTH 1 // Max 1 second of delay
-#define MULTITAP_BUFFER_LENGTH 1  // Max 1 second of multitap delay
-// 150ms buffer, to allow for 100ms + modulation time
-#define DIFFUSER_BUFFER_LENGTH 150
 
 // IMPORTANT: CHANGE "TotalLineCount" FOR DAISY SEED HARDWARE
 //            Original CloudSeed plugin uses 8 Delay Lines, or 12 delay lines?
@@ -33,6 +40,29 @@
 //            guitar pedal using Daisy Seed)
 #define MAX_DELAY_LINES 5
 
+// the pre-delay, the early diffuser stages, and each line's delay and
+// diffuser stages
+#define CHANNEL_LFO_COUNT                                                      \
+  ((MAX_DELAY_LINES + 1) * (1 + MAX_DIFFUSER_STAGE_COUNT))
+// starting phases of the modulators
+#define CHANNEL_LFO_SEED 8642
+// each line's delay and diffuser stages, when they run at a lower rate
+#define CHANNEL_LATE_LFO_COUNT                                                 \
+  (MAX_DELAY_LINES * (1 + MAX_DIFFUSER_STAGE_COUNT))
+
+static_assert(cloudSeed::seeds::contains(CHANNEL_LFO_SEED, CHANNEL_LFO_COUNT),
+              "the modulator phases are expanded at compile time");
+// the pre-delay, the multitap, and every early and line diffuser stage and
+// line delay
+#define CHANNEL_CLEAR_REGIONS                                                  \
+  (2 + (MAX_DELAY_LINES + 1) * MAX_DIFFUSER_STAGE_COUNT + MAX_DELAY_LINES)
+
+static_assert(CHANNEL_CLEAR_REGIONS <= CLEAR_QUEUE_LENGTH,
+              "a clear of the whole channel is queued at once");
+static_assert(MAX_DELAY_LINES * 3 <= SEED_VALUES_LINES,
+              "the seed table expands a delay, mod amount and mod rate per "
+              "line");
+
 static float DEFAULT_HIGH_PASS_FREQ = 20.0f;
 static float DEFAULT_LOW_PASS_FREQ = 20000.0f;
 
@@ -40,65 +70,304 @@ namespace cloudSeed {
 class ReverbChannel {
   private:
   float _parameters[(int)Parameter::Count];
-  int _MCU_CLOCK_RATE;
-
+  int _samplerate;
+  size_t _block_size;
+  // the late lines run this many times slower, at the rate and block size
+  // below
+  size_t _late_rate;
+  int _late_samplerate;
+  size_t _late_block_size;
+
+  // declared before the stages, which claim their slots while constructing.
+  // Lines running at a lower rate take theirs from the late bank.
+  LfoBank _lfo;
+  LfoBank _late_lfo;
   ModulatedDelay _pre_delay;
   MultitapDiffuser _multitap;
   AllpassDiffuser _diffuser;
   DelayLine* _lines[MAX_DELAY_LINES];
-  float* _delay_line_seeds;
+  LineFilterBank _line_filters;
+  LineControl _line_control;
+  // the settings the lines currently run with
+  LineSettings* _line_settings;
+  // around the late lines when they run at a lower rate
+  Decimator _decimator;
+  Interpolator _interpolator;
+  float* _late_input_buffer;
+  float* _late_out_buffer;
   daisysp::ATone _high_pass;
   daisysp::Tone _low_pass;
   float* _temp_buffer;
   float* _line_out_buffer;
-  float* _out_buffer;
+  InterpolationConfig _interpolation;
+  // the input of each stage, the lines track their input and loops together
+  SilenceTracker _pre_delay_silence;
+  SilenceTracker _multitap_silence;
+  SilenceTracker _diffuser_silence;
+  SilenceTracker _line_silence;
+  // every stage is silent, blocks of silent input skip them
+  bool _idle;
+  // zeroes the delay memory over the blocks after a clear was asked for,
+  // the stages it holds sit out until it is done
+  BufferClearer _clearer;
+  bool _clearing;
+  bool _clearing_diffuser;
+  bool _clearing_late_diffusers;
+  // nothing was written to the diffusers since they were last cleared, so
+  // switching them on needs no clear
+  bool _diffuser_clean;
+  bool _late_diffusers_clean;
+  // where process() records the time of each stage, see setProfiler
+  Profiler* _profiler;
+  struct {
+    size_t channel;
+    size_t input_filters;
+    size_t pre_delay;
+    size_t multitap;
+    size_t diffuser;
+    size_t decimator;
+    size_t lines[MAX_DELAY_LINES];
+    size_t line_filters;
+    size_t interpolator;
+    size_t output_mix;
+  } _stages;
 
-  int kdelay_line_seed;
   int kpost_diffusion_seed;
   size_t kline_count;
   bool khigh_pass_enabled;
   bool klow_pass_enabled;
   bool kdiffuser_enabled;
+  bool klate_diffusion_enabled;
+  bool kinterpolation_enabled;
+  bool kidle_detection;
   float kdry_out_gain;
   float kpredelay_out_gain;
   float kearly_out_gain;
   float kline_out_gain;
 
   public:
-  ReverbChannel()
-    : _pre_delay(PRE_DELAY_BUFFER_LENGTH),
-      _multitap(MULTITAP_BUFFER_LENGTH),
-      _diffuser(DIFFUSER_BUFFER_LENGTH) {
-    for (int i = 0; i < MAX_DELAY_LINES; i++)
-      _lines[i] = new DelayLine();
+  /**
+   * Params:
+   * sample_rate: the sample rate of the program in Hz, all buffers are sized
+   *              for this rate
+   * block_size: the maximum number of samples processed per tick
+   * storage: the sample format of each delay stage
+   * late_rate: the rate of the late lines, their delay memory shrinks with
+   *            it
+   */
+  ReverbChannel(int sample_rate,
+                size_t block_size,
+                const StorageConfig& storage = StorageConfig(),
+                LateRate late_rate = LateRate::Full)
+    : _samplerate(sample_rate),
+      _block_size(block_size),
+      _late_rate((size_t)late_rate),
+      _late_samplerate(sample_rate / (int)late_rate),
+      _late_block_size(Decimator::outputLength(block_size, _late_rate)),
+      _lfo(CHANNEL_LFO_COUNT, block_size, CHANNEL_LFO_SEED),
+      _late_lfo(_late_rate > 1 ? CHANNEL_LATE_LFO_COUNT : 0,
+                _late_block_size,
+                CHANNEL_LFO_SEED),
+      _pre_delay(reach::preDelay(sample_rate),
+                 block_size,
+                 _lfo,
+                 storage.pre_delay,
+                 "pre_delay"),
+      _multitap(reach::multitap(sample_rate, MAX_DIFFUSER_TAPS),
+                block_size,
+                storage.multitap),
+      _diffuser(reach::diffuserStage(sample_rate),
+                sample_rate,
+                block_size,
+                _lfo,
+                storage.diffuser,
+                "diffuser"),
+      _line_filters(MAX_DELAY_LINES, _late_samplerate, _late_block_size),
+      _line_control(MAX_DELAY_LINES, _late_samplerate),
+      _decimator(_late_rate, "late_resampler"),
+      _interpolator(_late_rate, "late_resampler"),
+      _pre_delay_silence(reach::preDelay(sample_rate) + block_size),
+      _multitap_silence(reach::multitap(sample_rate, MAX_DIFFUSER_TAPS) +
+                        block_size),
+      _diffuser_silence(_diffuserMemory(sample_rate) + block_size),
+      // the feedback ring delays the loop by another block
+      _line_silence(_lineMemory(sample_rate, block_size, late_rate)),
+      _idle(false),
+      _clearing(false),
+      _clearing_diffuser(false),
+      _clearing_late_diffusers(false),
+      _diffuser_clean(false),
+      _late_diffusers_clean(false) {
+    for (int i = 0; i < MAX_DELAY_LINES; i++) {
+      _lines[i] = new DelayLine(_late_samplerate,
+                                _late_block_size,
+                                _late_rate > 1 ? _late_lfo : _lfo,
+                                storage.line_delay,
+                                storage.line_diffuser);
+    }
 
     for (auto value = 0; value < (int)Parameter::Count; value++)
       _parameters[value] = 0.0;
 
     kline_count = MAX_DELAY_LINES;
-    _diffuser.setInterpolationEnabled(true);
-    _high_pass.Init(MCU_CLOCK_RATE);
+    khigh_pass_enabled = false;
+    klow_pass_enabled = false;
+    kdiffuser_enabled = false;
+    klate_diffusion_enabled = false;
+    kinterpolation_enabled = true;
+    kidle_detection = true;
+    _profiler = nullptr;
+    _stages = {};
+    _updateInterpolation();
+    _high_pass.Init(sample_rate);
     _high_pass.SetFreq(DEFAULT_HIGH_PASS_FREQ);
-    _low_pass.Init(MCU_CLOCK_RATE);
+    _low_pass.Init(sample_rate);
     _low_pass.SetFreq(DEFAULT_LOW_PASS_FREQ);
 
-    _temp_buffer = new float[BATCH_SIZE];
-    _line_out_buffer = new float[BATCH_SIZE];
-    _out_buffer = new float[BATCH_SIZE];
-    _delay_line_seeds = sdramAllocate<float>(MAX_DELAY_LINES * 3);
+    _temp_buffer = fastAllocate<float>(_block_size, "channel");
+    _line_out_buffer = fastAllocate<float>(_block_size, "channel");
+    _line_settings = fastAllocate<LineSettings>(MAX_DELAY_LINES, "channel");
+    _late_input_buffer = fastAllocate<float>(_lateBufferSize(), "channel");
+    _late_out_buffer = fastAllocate<float>(_lateBufferSize(), "channel");
   }
 
   ~ReverbChannel() {
     for (auto line : _lines)
       delete line;
+  }
+
+  /**
+   * The memory a channel asks of `tier`, see tierFootprint.
+   */
+  static constexpr size_t
+  arenaBytes(MemoryTier tier,
+             int sample_rate,
+             size_t block_size,
+             const StorageConfig& storage = StorageConfig(),
+             LateRate late_rate = LateRate::Full) {
+    return LfoBank::arenaBytes(tier, CHANNEL_LFO_COUNT, block_size) +
+           _lateArenaBytes(tier,
+                           sample_rate / (int)late_rate,
+                           Decimator::outputLength(block_size,
+                                                   (size_t)late_rate),
+                           storage,
+                           late_rate) +
+           ModulatedDelay::arenaBytes(tier,
+                                      reach::preDelay(sample_rate),
+                                      block_size,
+                                      storage.pre_delay) +
+           MultitapDiffuser::arenaBytes(
+             tier,
+             reach::multitap(sample_rate, MAX_DIFFUSER_TAPS),
+             block_size,
+             storage.multitap) +
+           AllpassDiffuser::arenaBytes(tier,
+                                       reach::diffuserStage(sample_rate),
+                                       block_size,
+                                       storage.diffuser) +
+           2 * tierFootprint(
+                 tier, MemoryTier::Fast, block_size * sizeof(float)) +
+           tierFootprint(
+             tier, MemoryTier::Fast, MAX_DELAY_LINES * sizeof(LineSettings));
+  }
+
+  /**
+   * The heap memory a channel takes besides itself, allocator overhead
+   * aside.
+   */
+  static constexpr size_t heapBytes() {
+    return AllpassDiffuser::heapBytes() +
+           MAX_DELAY_LINES * (sizeof(DelayLine) + DelayLine::heapBytes());
+  }
+
+  /**
+   * Derives the line settings from the line parameters changed since the
+   * last call, the audio thread picks them up on its next block. Call it at
+   * control rate from outside the audio thread.
+   */
+  void updateControls() {
+    _line_control.update();
+  }
+
+  /**
+   * Sets the kernel each modulated stage interpolates with. The
+   * Interpolation parameter still turns it off for the line diffusers.
+   */
+  void setInterpolation(const InterpolationConfig& interpolation) {
+    _interpolation = interpolation;
+    _updateInterpolation();
+  }
+
+  /**
+   * Sets how many samples apart the modulated delays move, lower is smoother
+   * and costs more.
+   */
+  void setModulationInterval(size_t samples) {
+    _lfo.setUpdateInterval(samples);
+    _late_lfo.setUpdateInterval(samples / _late_rate);
+  }
+
+  /**
+   * Sets how the late lines feed back into each other, independent loops by
+   * default. Mixed, the lines form a feedback delay network that is as dense
+   * with fewer lines.
+   */
+  void setLineMixing(LineMixing mixing) {
+    _line_filters.kmixing = mixing;
+  }
+
+  /**
+   * Records the ticks each stage takes per block into `profiler`, adding the
+   * stages to it, or stops recording when null. The resamplers are only
+   * added below the full rate.
+   */
+  void setProfiler(Profiler* profiler) {
+    static const char* const line_names[] = {
+      "line_0", "line_1", "line_2", "line_3", "line_4", "line_5",
+      "line_6", "line_7", "line_8", "line_9", "line_10", "line_11"};
+    static_assert(MAX_DELAY_LINES <= sizeof(line_names) / sizeof(char*),
+                  "every line is profiled under its own name");
+
+    _profiler = profiler;
+    if (profiler == nullptr)
+      return;
+    _stages.channel = profiler->add("channel");
+    _stages.input_filters = profiler->add("input_filters");
+    _stages.pre_delay = profiler->add("pre_delay");
+    _stages.multitap = profiler->add("multitap");
+    _stages.diffuser = profiler->add("diffuser");
+    if (_late_rate > 1)
+      _stages.decimator = profiler->add("decimator");
+    for (size_t i = 0; i < MAX_DELAY_LINES; i++)
+      _stages.lines[i] = profiler->add(line_names[i]);
+    _stages.line_filters = profiler->add("line_filters");
+    if (_late_rate > 1)
+      _stages.interpolator = profiler->add("interpolator");
+    _stages.output_mix = profiler->add("output_mix");
+  }
+
+  /**
+   * Turns skipping the stages once the tail has died out on or off. When on,
+   * the output differs from running every stage by less than the silence
+   * threshold.
+   */
+  void setIdleDetection(bool enabled) {
+    kidle_detection = enabled;
+    _idle = false;
+  }
 
-    delete _temp_buffer;
-    delete _line_out_buffer;
-    delete _out_buffer;
+  /**
+   * Only the dry signal was output for the last block.
+   */
+  bool isIdle() {
+    return _idle;
   }
 
-  float* getOutput() {
-    return _out_buffer;
+  /**
+   * Some delay memory is still being zeroed after a clear, see requestClear.
+   */
+  bool isClearing() {
+    return _clearer.isBusy();
   }
 
   float* _getLineOutput() {
@@ -134,8 +403,13 @@ class ReverbChannel {
 
     case Parameter::DiffusionEnabled: {
       auto newVal = value >= 0.5;
-      if (newVal != kdiffuser_enabled)
-        _diffuser.clearBuffers();
+      if (newVal != kdiffuser_enabled && !_diffuser_clean) {
+        // called from the audio callback, the memory is zeroed over the next
+        // blocks while the diffuser sits out
+        _diffuser.clearBuffers(&_clearer);
+        _diffuser_silence.reset();
+        _clearing_diffuser = true;
+      }
       kdiffuser_enabled = newVal;
       break;
     }
@@ -150,31 +424,36 @@ class ReverbChannel {
       break;
 
     case Parameter::LineCount:
-      kline_count = (int)value; // Originally commented out
+      // Originally commented out. Clamp to the lines that were actually
+      // allocated, the unscaled parameter maps to up to 12 lines.
+      kline_count = std::max(1, std::min((int)value, MAX_DELAY_LINES));
       // per_line_gain = GetPerLineGain();  // In original Cloud Seed
       break;
     case Parameter::LineDelay:
-      _updateLines();
+      _line_control.setDelay(value);
       break;
     case Parameter::LineDecay:
-      _updateLines();
+      _line_control.setDecay(value);
       break;
 
-    case Parameter::LateDiffusionEnabled:
-      for (auto line : _lines) {
-        auto newVal = value >= 0.5;
-        if (newVal != line->kdiffuser_enabled)
-          line->clearDiffuserBuffer();
-        line->kdiffuser_enabled = newVal;
+    case Parameter::LateDiffusionEnabled: {
+      auto newVal = value >= 0.5;
+      if (newVal != klate_diffusion_enabled && !_late_diffusers_clean) {
+        for (auto line : _lines)
+          line->clearDiffuserBuffer(&_clearer);
+        _clearing_late_diffusers = true;
       }
+      klate_diffusion_enabled = newVal;
+      _applyLateDiffusion();
       break;
+    }
     case Parameter::LateDiffusionStages:
       for (auto line : _lines)
         line->setDiffuserStages((int)value);
       break;
     case Parameter::LateDiffusionDelay:
       for (auto line : _lines)
-        line->setDiffuserDelay((int)_ms2Samples(value));
+        line->setDiffuserDelay((int)(_ms2Samples(value) / _late_rate));
       break;
     case Parameter::LateDiffusionFeedback:
       for (auto line : _lines)
@@ -182,24 +461,19 @@ class ReverbChannel {
       break;
 
     case Parameter::PostLowShelfGain:
-      for (auto line : _lines)
-        line->setLowShelfGain(value);
+      _line_filters.setLowShelfGain(value);
       break;
     case Parameter::PostLowShelfFrequency:
-      for (auto line : _lines)
-        line->setLowShelfFrequency(value);
+      _line_filters.setLowShelfFrequency(value);
       break;
     case Parameter::PostHighShelfGain:
-      for (auto line : _lines)
-        line->setHighShelfGain(value);
+      _line_filters.setHighShelfGain(value);
       break;
     case Parameter::PostHighShelfFrequency:
-      for (auto line : _lines)
-        line->setHighShelfFrequency(value);
+      _line_filters.setHighShelfFrequency(value);
       break;
     case Parameter::PostCutoffFrequency:
-      for (auto line : _lines)
-        line->setCutoffFrequency(value);
+      _line_filters.setCutoffFrequency(value);
       break;
 
     case Parameter::EarlyDiffusionModAmount:
@@ -210,16 +484,16 @@ class ReverbChannel {
       _diffuser.setModRate(value);
       break;
     case Parameter::LineModAmount:
-      _updateLines();
+      _line_control.setModAmount(value);
       break;
     case Parameter::LineModRate:
-      _updateLines();
+      _line_control.setModRate(value);
       break;
     case Parameter::LateDiffusionModAmount:
-      _updateLines();
+      _line_control.setDiffuserModAmount(value);
       break;
     case Parameter::LateDiffusionModRate:
-      _updateLines();
+      _line_control.setDiffuserModRate(value);
       break;
 
     case Parameter::TapSeed:
@@ -229,8 +503,7 @@ class ReverbChannel {
       _diffuser.setSeed((int)value);
       break;
     case Parameter::DelaySeed:
-      kdelay_line_seed = (int)value;
-      _updateLines();
+      _line_control.setSeed((int)value);
       break;
     case Parameter::PostDiffusionSeed:
       kpost_diffusion_seed = (int)value;
@@ -257,16 +530,13 @@ class ReverbChannel {
       klow_pass_enabled = value >= 0.5;
       break;
     case Parameter::LowShelfEnabled:
-      for (auto line : _lines)
-        line->klow_shelf_enabled = value >= 0.5;
+      _line_filters.klow_shelf_enabled = value >= 0.5;
       break;
     case Parameter::HighShelfEnabled:
-      for (auto line : _lines)
-        line->khigh_shelf_enabled = value >= 0.5;
+      _line_filters.khigh_shelf_enabled = value >= 0.5;
       break;
     case Parameter::CutoffEnabled:
-      for (auto line : _lines)
-        line->kcutoff_enabled = value >= 0.5;
+      _line_filters.kcutoff_enabled = value >= 0.5;
       break;
     case Parameter::LateStageTap:
       for (auto line : _lines)
@@ -274,147 +544,295 @@ class ReverbChannel {
       break;
 
     case Parameter::Interpolation:
-      for (auto line : _lines)
-        line->setInterpolationEnabled(value >= 0.5);
+      kinterpolation_enabled = value >= 0.5;
+      _updateInterpolation();
       break;
     default:
       break;
     }
   }
 
-  void tick(float* input) {
-    auto predelayOutput = _pre_delay.getOutput();
+  /**
+   * Processes `len` samples, at most the block size, writing the mixed
+   * output straight into `output`. `input` and `output` may be the same
+   * buffer.
+   */
+  void process(const float* input, float* output, size_t len) {
+    ScopedTimer channel_timer(_profiler, _stages.channel);
+    if (_line_control.consume(_line_settings))
+      _applyLineSettings();
+
+    if (_clearer.isBusy()) {
+      if (!_clearer.step(CLEAR_BYTES_PER_SAMPLE * len))
+        _finishClear();
+      if (_clearing) {
+        // the stages start again once all of their memory is zeroed
+        _lfo.skip(len);
+        _skipLate(len);
+        for (size_t i = 0; i < len; i++)
+          output[i] = kdry_out_gain * input[i];
+        return;
+      }
+    }
 
-    if (!klow_pass_enabled && !khigh_pass_enabled) {
-      memcpy(_temp_buffer, input, BATCH_SIZE);
-    } else {
-      for (size_t i = 0; i < BATCH_SIZE; i++) {
-        if (khigh_pass_enabled) {
-          _temp_buffer[i] = _high_pass.Process(input[i]);
-        }
-        if (klow_pass_enabled) {
-          auto lowPassInput = khigh_pass_enabled ? _temp_buffer[i] : input[i];
-          _temp_buffer[i] = _low_pass.Process(lowPassInput);
-        }
+    {
+      ScopedTimer timer(_profiler, _stages.input_filters);
+      for (size_t i = 0; i < len; i++) {
+        auto n = input[i];
+        if (khigh_pass_enabled)
+          n = _high_pass.Process(n);
+        if (klow_pass_enabled)
+          n = _low_pass.Process(n);
+
+        // completely zero if no input present
+        // Previously, the very small values were causing some really strange
+        // CPU spikes
+        _temp_buffer[i] = n * n < SILENCE_THRESHOLD ? 0 : n;
       }
     }
 
-    // completely zero if no input present
-    // Previously, the very small values were causing some really strange CPU
-    // spikes
-    for (size_t i = 0; i < BATCH_SIZE; i++) {
-      auto n = _temp_buffer[i];
-      if (n * n < 0.000000001)
-        _temp_buffer[i] = 0;
+    if (_idle) {
+      // nothing is left of the tail, until the input returns only the dry
+      // signal is output. The stages were silent when they stopped, so they
+      // start again without a click.
+      if (SilenceTracker::power(_temp_buffer, len) < SILENCE_THRESHOLD) {
+        _lfo.skip(len);
+        _skipLate(len);
+        for (size_t i = 0; i < len; i++)
+          output[i] = kdry_out_gain * input[i];
+        return;
+      }
+      _idle = false;
     }
 
-    auto pre_delay_output = _pre_delay.tick(_temp_buffer);
-    auto multitap_output = _multitap.tick(pre_delay_output);
+    _lfo.tick(len);
 
-    if (kdiffuser_enabled) {
-      auto diffuser_output = _diffuser.tick(multitap_output);
-      memcpy(_temp_buffer, diffuser_output, BATCH_SIZE);
-    } else {
-      memcpy(_temp_buffer, multitap_output, BATCH_SIZE);
+    float* pre_delay_output;
+    float* early_output;
+    {
+      ScopedTimer timer(_profiler, _stages.pre_delay);
+      pre_delay_output = _pre_delay.tick(_temp_buffer, len);
+    }
+    {
+      ScopedTimer timer(_profiler, _stages.multitap);
+      early_output = _multitap.tick(pre_delay_output, len);
+    }
+    _pre_delay_silence.track(_temp_buffer, len);
+    _multitap_silence.track(pre_delay_output, len);
+    if (kdiffuser_enabled && !_clearing_diffuser) {
+      _diffuser_silence.track(early_output, len);
+      ScopedTimer timer(_profiler, _stages.diffuser);
+      early_output = _diffuser.tick(early_output, len);
+      _diffuser_clean = false;
     }
-
-    auto earlyOutStage = _temp_buffer;
 
     // mix in the feedback from the other channel
     // for (int i = 0; i < len; i++)
     //	tempBuffer[i] += crossMix[i];
 
-    for (size_t i = 0; i < kline_count; i++)
-      _lines[i]->tick(_temp_buffer);
+    // at a lower rate the lines run over the samples the decimator put out
+    // and the interpolator brings their sum back up
+    auto late_input = early_output;
+    auto late_output = _line_out_buffer;
+    auto late_len = len;
+    if (_late_rate > 1) {
+      ScopedTimer timer(_profiler, _stages.decimator);
+      late_len = _decimator.process(early_output, _late_input_buffer, len);
+      late_input = _late_input_buffer;
+      late_output = _late_out_buffer;
+      _late_lfo.tick(late_len);
+    }
 
-    for (size_t i = 0; i < kline_count; i++) {
-      auto buf = _lines[i]->getOutput();
+    auto line_power = SilenceTracker::power(early_output, len);
+    if (late_len > 0) {
+      for (size_t i = 0; i < kline_count; i++) {
+        ScopedTimer timer(_profiler, _stages.lines[i]);
+        _lines[i]->tick(late_input, late_len);
+      }
+      {
+        ScopedTimer timer(_profiler, _stages.line_filters);
+        _line_filters.tick(_lines, kline_count, late_len);
+      }
+      _late_diffusers_clean &= !_lines[0]->kdiffuser_enabled;
 
-      if (i == 0) {
-        for (int j = 0; j < BATCH_SIZE; j++)
-          _temp_buffer[j] = buf[j];
-      } else {
-        for (int j = 0; j < BATCH_SIZE; j++)
-          _temp_buffer[j] += buf[j];
+      for (size_t i = 0; i < kline_count; i++) {
+        line_power =
+          std::max(line_power,
+                   SilenceTracker::power(_lines[i]->getLoopOutput(), late_len));
       }
+
+      for (size_t i = 0; i < kline_count; i++) {
+        auto buf = _lines[i]->getOutput();
+
+        if (i == 0) {
+          for (size_t j = 0; j < late_len; j++)
+            late_output[j] = buf[j];
+        } else {
+          for (size_t j = 0; j < late_len; j++)
+            late_output[j] += buf[j];
+        }
+      }
+
+      auto per_line_gain = _getPerLineGain();
+      utils::gain(late_output, per_line_gain, late_len);
     }
+    _line_silence.track(line_power, len);
 
-    auto per_line_gain = _getPerLineGain();
-    utils::gain(_temp_buffer, per_line_gain, BATCH_SIZE);
-    utils::copy(_line_out_buffer, _temp_buffer, BATCH_SIZE);
+    if (_late_rate > 1) {
+      ScopedTimer timer(_profiler, _stages.interpolator);
+      _interpolator.process(late_output, _line_out_buffer, len);
+    }
 
-    for (size_t i = 0; i < BATCH_SIZE; i++) {
-      _out_buffer[i] = kdry_out_gain * input[i] +               //
-                       kpredelay_out_gain * predelayOutput[i] + //
-                       kearly_out_gain * earlyOutStage[i] +     //
-                       kline_out_gain * _temp_buffer[i];
+    {
+      ScopedTimer timer(_profiler, _stages.output_mix);
+      for (size_t i = 0; i < len; i++) {
+        output[i] = kdry_out_gain * input[i] +                 //
+                    kpredelay_out_gain * pre_delay_output[i] + //
+                    kearly_out_gain * early_output[i] +        //
+                    kline_out_gain * _line_out_buffer[i];
+      }
     }
+
+    _idle = kidle_detection && _pre_delay_silence.isSilent() &&
+            _multitap_silence.isSilent() && _diffuser_silence.isSilent() &&
+            _line_silence.isSilent();
   }
 
+  /**
+   * Zeroes all delay memory at once, for when no audio is running.
+   */
   void clearBuffers() {
-    for (int i = 0; i < BATCH_SIZE; i++) {
+    requestClear();
+    _clearer.finish();
+    _finishClear();
+  }
+
+  /**
+   * Clears the channel like clearBuffers(), zeroing the delay memory over the
+   * blocks that follow instead of at once, so it can be called from the
+   * audio callback. Only the dry signal is output until it is done, under a
+   * tenth of a second on the pedal.
+   */
+  void requestClear() {
+    for (size_t i = 0; i < _block_size; i++) {
       _temp_buffer[i] = 0.0;
       _line_out_buffer[i] = 0.0;
-      _out_buffer[i] = 0.0;
     }
+    _decimator.reset();
+    _interpolator.reset();
 
-    _pre_delay.clearBuffers();
-    _multitap.clearBuffers();
-    _diffuser.clearBuffers();
+    _pre_delay.clearBuffers(&_clearer);
+    _multitap.clearBuffers(&_clearer);
+    _diffuser.clearBuffers(&_clearer);
     for (auto line : _lines)
-      line->clearBuffers();
+      line->clearBuffers(&_clearer);
+    _line_filters.clearBuffers();
+
+    _pre_delay_silence.reset();
+    _multitap_silence.reset();
+    _diffuser_silence.reset();
+    _line_silence.reset();
+    _clearing = true;
   }
 
   private:
+  static size_t _diffuserMemory(int sample_rate) {
+    return MAX_DIFFUSER_STAGE_COUNT * reach::diffuserStage(sample_rate);
+  }
+
+  /**
+   * The longest the late lines hold a sample, in samples of the program's
+   * rate.
+   */
+  static size_t
+  _lineMemory(int sample_rate, size_t block_size, LateRate late_rate) {
+    auto factor = (size_t)late_rate;
+    auto late_sample_rate = sample_rate / (int)factor;
+    auto late_block_size = Decimator::outputLength(block_size, factor);
+    return (reach::lineDelay(late_sample_rate) +
+            _diffuserMemory(late_sample_rate) + 2 * late_block_size) *
+             factor +
+           resampling::delay(factor);
+  }
+
+  /**
+   * The memory of the late lines and what runs at their rate.
+   */
+  static constexpr size_t _lateArenaBytes(MemoryTier tier,
+                                          int late_sample_rate,
+                                          size_t late_block_size,
+                                          const StorageConfig& storage,
+                                          LateRate late_rate) {
+    return LfoBank::arenaBytes(
+             tier,
+             late_rate == LateRate::Full ? 0 : CHANNEL_LATE_LFO_COUNT,
+             late_block_size) +
+           LineFilterBank::arenaBytes(
+             tier, MAX_DELAY_LINES, late_block_size) +
+           LineControl::arenaBytes(tier, MAX_DELAY_LINES) +
+           MAX_DELAY_LINES * DelayLine::arenaBytes(tier,
+                                                   late_sample_rate,
+                                                   late_block_size,
+                                                   storage.line_delay,
+                                                   storage.line_diffuser) +
+           Decimator::arenaBytes(tier, (size_t)late_rate) +
+           Interpolator::arenaBytes(tier, (size_t)late_rate) +
+           2 * tierFootprint(
+                 tier,
+                 MemoryTier::Fast,
+                 (late_rate == LateRate::Full ? 0 : late_block_size) *
+                   sizeof(float));
+  }
+
+  /**
+   * The samples of the buffers between the resamplers and the late lines,
+   * none at the full rate.
+   */
+  size_t _lateBufferSize() {
+    return _late_rate > 1 ? _late_block_size : 0;
+  }
+
+  /**
+   * Moves the late lines on over `len` skipped samples.
+   */
+  void _skipLate(size_t len) {
+    if (_late_rate > 1) {
+      _late_lfo.skip(_decimator.skip(len));
+      _interpolator.skip(len);
+    }
+  }
+
   float _getPerLineGain() {
     return 1.0 / std::sqrt(kline_count);
   }
 
-  void _updateLines() {
-    auto lineDelaySamples =
-      (int)_ms2Samples(_parameters[(int)Parameter::LineDelay]);
-    auto lineDecayMillis = _parameters[(int)Parameter::LineDecay] * 1000;
-    auto lineDecaySamples = _ms2Samples(lineDecayMillis);
-
-    auto lineModAmount =
-      _ms2Samples(_parameters[(int)Parameter::LineModAmount]);
-    auto lineModRate = _parameters[(int)Parameter::LineModRate];
+  void _finishClear() {
+    _diffuser_clean |= _clearing || _clearing_diffuser;
+    _late_diffusers_clean |= _clearing || _clearing_late_diffusers;
+    _clearing = false;
+    _clearing_diffuser = false;
+    _clearing_late_diffusers = false;
+    _applyLateDiffusion();
+  }
 
-    auto lateDiffusionModAmount =
-      _ms2Samples(_parameters[(int)Parameter::LateDiffusionModAmount]);
-    auto lateDiffusionModRate =
-      _parameters[(int)Parameter::LateDiffusionModRate];
+  /**
+   * The late diffusers sit out while their memory is being zeroed.
+   */
+  void _applyLateDiffusion() {
+    for (auto line : _lines)
+      line->kdiffuser_enabled =
+        klate_diffusion_enabled && !_clearing_late_diffusers;
+  }
 
-    auto seeds =
-      audioLib::sharandom::generate(kdelay_line_seed, MAX_DELAY_LINES * 3);
-    std::copy(seeds.begin(), seeds.end(), _delay_line_seeds);
+  void _applyLineSettings() {
     for (size_t i = 0; i < MAX_DELAY_LINES; i++) {
-      auto modAmount =
-        lineModAmount * (0.7 + 0.3 * _delay_line_seeds[i + MAX_DELAY_LINES]);
-      auto modRate = lineModRate *
-                     (0.7 + 0.3 * _delay_line_seeds[i + 2 * MAX_DELAY_LINES]) /
-                     MCU_CLOCK_RATE;
-
-      auto delaySamples = (0.5 + 1.0 * _delay_line_seeds[i]) * lineDelaySamples;
-      // when the delay is set really short,
-      // and the modulation is very high
-      if (delaySamples < modAmount + 2) {
-        // the mod could actually take the delay time negative, prevent
-        // that! -- provide 2 extra sample as margin of safety
-        delaySamples = modAmount + 2;
-      }
-
-      auto dbAfter1Iteration =
-        delaySamples / lineDecaySamples *
-        (-60); // lineDecay is the time it takes to reach T60
-      auto gainAfter1Iteration = utils::DB2gain(dbAfter1Iteration);
-
-      _lines[i]->setDelay((int)delaySamples);
-      _lines[i]->setFeedback(gainAfter1Iteration);
-      _lines[i]->setLineModAmount(modAmount);
-      _lines[i]->setLineModRate(modRate);
-      _lines[i]->setDiffuserModAmount(lateDiffusionModAmount);
-      _lines[i]->setDiffuserModRate(lateDiffusionModRate);
+      auto& settings = _line_settings[i];
+      _lines[i]->setDelay(settings.delay);
+      _lines[i]->setFeedback(settings.feedback);
+      _lines[i]->setLineModAmount(settings.mod_amount);
+      _lines[i]->setLineModRate(settings.mod_rate);
+      _lines[i]->setDiffuserModAmount(settings.diffuser_mod_amount);
+      _lines[i]->setDiffuserModRate(settings.diffuser_mod_rate);
     }
   }
 
@@ -423,8 +841,19 @@ class ReverbChannel {
       _lines[i]->setDiffuserSeed(((long long)kpost_diffusion_seed) * (i + 1));
   }
 
+  void _updateInterpolation() {
+    _pre_delay.kinterpolation = _interpolation.pre_delay;
+    _diffuser.setInterpolation(_interpolation.diffuser);
+    auto line_diffuser = kinterpolation_enabled ? _interpolation.line_diffuser
+                                                : Interpolation::None;
+    for (auto line : _lines) {
+      line->setDelayInterpolation(_interpolation.line_delay);
+      line->setDiffuserInterpolation(line_diffuser);
+    }
+  }
+
   float _ms2Samples(float value) {
-    return value / 1000.0 * _MCU_CLOCK_RATE;
+    return value / 1000.0 * _samplerate;
   }
 };
 
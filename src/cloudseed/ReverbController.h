@@ -8,6 +8,7 @@
 
 #include "../constants.h"
 #include "AllpassDiffuser.h"
+#include "DelayReach.h"
 #include "MultitapDiffuser.h"
 #include "ReverbController.h"
 #include "Utils.h"
@@ -18,13 +19,65 @@ using namespace audioLib;
 
 class ReverbController {
   private:
+  int _samplerate;
+  size_t _block_size;
   ReverbChannel _channel;
-  float _left_channel_in[BATCH_SIZE];
   // TODO (baylessj): we have two places where parameters are stored currently,
   // leave these to be just stored in the channel?
   float _parameters[(int)Parameter::Count];
 
   public:
+  /**
+   * Params:
+   * sample_rate: the sample rate in Hz, delay memory is allocated for this
+   *              rate only
+   * block_size: the number of samples processed per tick. The pedal uses
+   * small blocks to keep latency down, offline hosts can use much larger
+   * blocks for throughput. Each late line feeds back the previous block, so
+   * the block size is added to the line delays and slightly colours the tail.
+   * storage: the sample format of each delay stage, the 16 bit formats halve
+   * the delay memory of a stage
+   * late_rate: the rate the late lines run at, a half or a quarter of the
+   * sample rate roughly halves or quarters their cost and delay memory,
+   * trading away the top of the tail's spectrum
+   */
+  ReverbController(int sample_rate = MCU_CLOCK_RATE,
+                   size_t block_size = BATCH_SIZE,
+                   const StorageConfig& storage = StorageConfig(),
+                   LateRate late_rate = LateRate::Full)
+    : _samplerate(sample_rate),
+      _block_size(block_size),
+      _channel(sample_rate, block_size, storage, late_rate) {}
+
+  /**
+   * The memory a controller asks of `tier`, see tierFootprint.
+   */
+  static constexpr size_t
+  arenaBytes(MemoryTier tier,
+             int sample_rate,
+             size_t block_size,
+             const StorageConfig& storage = StorageConfig(),
+             LateRate late_rate = LateRate::Full) {
+    return ReverbChannel::arenaBytes(
+      tier, sample_rate, block_size, storage, late_rate);
+  }
+
+  /**
+   * The heap memory a controller takes besides itself, allocator overhead
+   * aside.
+   */
+  static constexpr size_t heapBytes() {
+    return ReverbChannel::heapBytes();
+  }
+
+  int getSampleRate() {
+    return _samplerate;
+  }
+
+  size_t getBlockSize() {
+    return _block_size;
+  }
+
   float* getAllParameters() {
     return _parameters;
   }
@@ -35,7 +88,7 @@ class ReverbController {
     case Parameter::InputMix:
       return P(Parameter::InputMix);
     case Parameter::PreDelay:
-      return (int)(P(Parameter::PreDelay) * 1000);
+      return (int)(P(Parameter::PreDelay) * MAX_PRE_DELAY_MS);
 
     case Parameter::HighPass:
       return 20 + valueTables::Get(P(Parameter::HighPass),
@@ -50,7 +103,7 @@ class ReverbController {
     case Parameter::TapCount:
       return 1 + (int)(P(Parameter::TapCount) * (MAX_DIFFUSER_TAPS - 1));
     case Parameter::TapLength:
-      return (int)(P(Parameter::TapLength) * 500);
+      return (int)(P(Parameter::TapLength) * MAX_TAP_LENGTH_MS);
     case Parameter::TapGain:
       return valueTables::Get(P(Parameter::TapGain), valueTables::Response2Dec);
     case Parameter::TapDecay:
@@ -62,7 +115,9 @@ class ReverbController {
       return 1 + (int)(P(Parameter::DiffusionStages) *
                        (MAX_DIFFUSER_STAGE_COUNT - 0.001));
     case Parameter::DiffusionDelay:
-      return (int)(10 + P(Parameter::DiffusionDelay) * 90);
+      return (int)(MIN_DIFFUSION_DELAY_MS +
+                   P(Parameter::DiffusionDelay) *
+                     (MAX_DIFFUSION_DELAY_MS - MIN_DIFFUSION_DELAY_MS));
     case Parameter::DiffusionFeedback:
       return P(Parameter::DiffusionFeedback);
 
@@ -70,9 +125,10 @@ class ReverbController {
     case Parameter::LineCount:
       return 1 + (int)(P(Parameter::LineCount) * 11.999);
     case Parameter::LineDelay:
-      return (int)(20.0 + valueTables::Get(P(Parameter::LineDelay),
-                                           valueTables::Response2Dec) *
-                            980);
+      return (int)((double)MIN_LINE_DELAY_MS +
+                   valueTables::Get(P(Parameter::LineDelay),
+                                    valueTables::Response2Dec) *
+                     (MAX_LINE_DELAY_MS - MIN_LINE_DELAY_MS));
     case Parameter::LineDecay:
       return 0.05 + valueTables::Get(P(Parameter::LineDecay),
                                      valueTables::Response3Dec) *
@@ -84,7 +140,9 @@ class ReverbController {
       return 1 + (int)(P(Parameter::LateDiffusionStages) *
                        (MAX_DIFFUSER_STAGE_COUNT - 0.001));
     case Parameter::LateDiffusionDelay:
-      return (int)(10 + P(Parameter::LateDiffusionDelay) * 90);
+      return (int)(MIN_DIFFUSION_DELAY_MS +
+                   P(Parameter::LateDiffusionDelay) *
+                     (MAX_DIFFUSION_DELAY_MS - MIN_DIFFUSION_DELAY_MS));
     case Parameter::LateDiffusionFeedback:
       return P(Parameter::LateDiffusionFeedback);
 
@@ -110,19 +168,19 @@ class ReverbController {
 
     // Modulation
     case Parameter::EarlyDiffusionModAmount:
-      return P(Parameter::EarlyDiffusionModAmount) * 2.5;
+      return P(Parameter::EarlyDiffusionModAmount) * MAX_MOD_AMOUNT_MS;
     case Parameter::EarlyDiffusionModRate:
       return valueTables::Get(P(Parameter::EarlyDiffusionModRate),
                               valueTables::Response2Dec) *
              5;
     case Parameter::LineModAmount:
-      return P(Parameter::LineModAmount) * 2.5;
+      return P(Parameter::LineModAmount) * MAX_MOD_AMOUNT_MS;
     case Parameter::LineModRate:
       return valueTables::Get(P(Parameter::LineModRate),
                               valueTables::Response2Dec) *
              5;
     case Parameter::LateDiffusionModAmount:
-      return P(Parameter::LateDiffusionModAmount) * 2.5;
+      return P(Parameter::LateDiffusionModAmount) * MAX_MOD_AMOUNT_MS;
     case Parameter::LateDiffusionModRate:
       return valueTables::Get(P(Parameter::LateDiffusionModRate),
                               valueTables::Response2Dec) *
@@ -185,17 +243,124 @@ class ReverbController {
     _channel.setParameter(param, scaled);
   }
 
+  /**
+   * Apply a full set of unscaled parameters, e.g. one of the factory programs
+   * in presets.h.
+   */
+  void setAllParameters(const float* parameters) {
+    for (int i = 0; i < (int)Parameter::Count; i++)
+      setParameter((Parameter)i, parameters[i]);
+  }
+
   void clearBuffers() {
     _channel.clearBuffers();
   }
 
-  void tick(float* input, float* output) {
-    memcpy(_left_channel_in, input, BATCH_SIZE);
+  /**
+   * See ReverbChannel::requestClear.
+   */
+  void requestClear() {
+    _channel.requestClear();
+  }
+
+  bool isClearing() {
+    return _channel.isClearing();
+  }
+
+  /**
+   * Does the control rate work of the parameter changes made since the last
+   * call, process() applies the result at the start of its next block. Call
+   * it periodically from outside the audio callback, e.g. the main loop, and
+   * once after setting parameters when rendering offline.
+   */
+  void updateControls() {
+    _channel.updateControls();
+  }
+
+  /**
+   * Sets the fractional delay kernel of each modulated stage, all linear by
+   * default.
+   */
+  void setInterpolation(const InterpolationConfig& interpolation) {
+    _channel.setInterpolation(interpolation);
+  }
+
+  /**
+   * Sets how many samples apart the modulated delays are moved, defaults to
+   * LFO_UPDATE_INTERVAL.
+   */
+  void setModulationInterval(size_t samples) {
+    _channel.setModulationInterval(samples);
+  }
+
+  /**
+   * Sets how the late lines feed back into each other, see LineMixing.
+   */
+  void setLineMixing(LineMixing mixing) {
+    _channel.setLineMixing(mixing);
+  }
+
+  /**
+   * Records the ticks each stage of the engine takes per block into
+   * `profiler`, or stops recording when null, see ReverbChannel::setProfiler.
+   */
+  void setProfiler(Profiler* profiler) {
+    _channel.setProfiler(profiler);
+  }
+
+  /**
+   * Skips the reverb stages while the input and the tail are silent, on by
+   * default.
+   */
+  void setIdleDetection(bool enabled) {
+    _channel.setIdleDetection(enabled);
+  }
+
+  /**
+   * The last block processed only output the dry signal.
+   */
+  bool isIdle() {
+    return _channel.isIdle();
+  }
+
+  /**
+   * Renders the impulse response of the current parameters into `response`,
+   * `len` samples, from cleared buffers, and clears them again after.
+   * Returns the length up to the last sample above SILENCE_THRESHOLD, the
+   * rest can be dropped.
+   *
+   * With the modulation off every stage is linear and time invariant, so a
+   * PartitionedConvolver playing the response back reproduces the preset at
+   * a cost fixed by its length, and serves as a reference for the stages.
+   */
+  size_t renderImpulseResponse(float* response, size_t len) {
+    clearBuffers();
+    std::fill(response, response + len, 0.0f);
+    if (len > 0)
+      response[0] = 1;
+    process(response, response, len);
+    clearBuffers();
+
+    while (len > 0 &&
+           response[len - 1] * response[len - 1] < SILENCE_THRESHOLD)
+      len--;
+    return len;
+  }
 
-    _channel.tick(_left_channel_in);
-    auto left_out = _channel.getOutput();
+  /**
+   * Processes `frames` samples of mono audio. Any frame count is accepted,
+   * it is split into blocks of at most the configured block size internally.
+   * `input` and `output` may be the same buffer.
+   */
+  void process(const float* input, float* output, size_t frames) {
+    while (frames > 0) {
+      auto len = std::min(frames, _block_size);
+      _channel.process(input, output, len);
 
-    memcpy(output, left_out, BATCH_SIZE);
+      input += len;
+      output += len;
+      frames -= len;
+    }
   }
 
   private:
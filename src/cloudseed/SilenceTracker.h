@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// Power below which a sample counts as silent, about -90dB
+#define SILENCE_THRESHOLD 0.000000001
+
+namespace cloudSeed {
+/**
+ * Tracks how long the input of a stage has been silent. A stage can only
+ * output what it was given within its memory, the longest it can delay a
+ * sample, so once its input has been silent for that long its state is
+ * silent too and it can be skipped without changing its output.
+ */
+class SilenceTracker {
+  public:
+  /**
+   * Params:
+   * memory: the longest the stage can delay a sample, in samples
+   */
+  SilenceTracker(size_t memory) : _memory(memory), _silent_for(memory) {}
+
+  /**
+   * Tracks the `len` samples the stage was just given.
+   */
+  void track(const float* input, size_t len) {
+    track(power(input, len), len);
+  }
+
+  /**
+   * Tracks `len` samples given the peak power among them.
+   */
+  void track(float peak_power, size_t len) {
+    if (peak_power < SILENCE_THRESHOLD)
+      _silent_for = std::min(_silent_for + len, _memory);
+    else
+      _silent_for = 0;
+  }
+
+  /**
+   * Everything the stage holds is silent.
+   */
+  bool isSilent() {
+    return _silent_for >= _memory;
+  }
+
+  /**
+   * Marks the stage silent, for when its state was cleared.
+   */
+  void reset() {
+    _silent_for = _memory;
+  }
+
+  /**
+   * The peak power of `len` samples.
+   */
+  static float power(const float* buffer, size_t len) {
+    float peak = 0;
+    for (size_t i = 0; i < len; i++)
+      peak = std::max(peak, buffer[i] * buffer[i]);
+    return peak;
+  }
+
+  private:
+  size_t _memory;
+  size_t _silent_for;
+};
+} // namespace cloudSeed
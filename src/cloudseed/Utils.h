@@ -2,8 +2,13 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 namespace cloudSeed {
 namespace utils {
 
@@ -40,6 +45,31 @@ inline void bitcrushAndReduce(float* bufferIn,
   }
 }
 
+/**
+ * Flushes denormals to zero on the calling thread where the platform supports
+ * it. The decaying tails are full of them and each can cost a hundred cycles.
+ * On the Cortex-M7 it is also made the default of interrupt handlers, which
+ * is where the audio callback runs.
+ */
+inline void enableFlushToZero() {
+#if defined(__SSE__)
+  // FTZ and DAZ
+  _mm_setcsr(_mm_getcsr() | 0x8040);
+#elif defined(__aarch64__)
+  std::uint64_t fpcr;
+  __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+  __asm__ volatile("msr fpcr, %0" : : "r"(fpcr | (1 << 24)));
+#elif defined(__ARM_FP)
+  std::uint32_t fpscr;
+  __asm__ volatile("vmrs %0, fpscr" : "=r"(fpscr));
+  __asm__ volatile("vmsr fpscr, %0" : : "r"(fpscr | (1 << 24)));
+#if defined(__ARM_ARCH_7EM__)
+  // FPDSCR, the FPSCR exception handlers start with
+  *(volatile std::uint32_t*)0xE000EF3C |= 1 << 24;
+#endif
+#endif
+}
+
 template <typename T> static float DB2gain(T input) {
   return std::pow(10, input / 20.0);
 }
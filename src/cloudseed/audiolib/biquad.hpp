@@ -58,7 +58,7 @@ class Biquad {
     return y;
   }
 
-  void inline tick(float* input, float* output, int len) {
+  void inline tick(const float* input, float* output, int len) {
     for (int i = 0; i < len; i++)
       output[i] = tick(input[i]);
   }
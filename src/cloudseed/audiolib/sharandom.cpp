@@ -1,232 +1,56 @@
-/*
- * Updated to C++, zedwood.com 2012
- * Based on Olivier Gay's version
- * See Modified BSD License below:
- *
- * FIPS 180-2 SHA-224/256/384/512 implementation
- * Issue date:  04/30/2005
- * http://www.ouah.org/ogay/sha2/
- *
- * Copyright (C) 2005, 2007 Olivier Gay <olivier.gay@a3.epfl.ch>
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. Neither the name of the project nor the names of its contributors
- *    may be used to endorse or promote products derived from this software
- *    without specific prior written permission.
- *
- * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
- * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
- * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
- * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
- * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
- * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
- * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
- * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
- * SUCH DAMAGE.
- */
-#include <climits>
-#include <cstring>
-#include <fstream>
-#include <memory>
-#include <vector>
+#include <algorithm>
+#include <atomic>
 
 #include "sharandom.h"
 
-class SHA256 {
-  protected:
-  typedef unsigned char uint8;
-  typedef unsigned int uint32;
-  typedef unsigned long long uint64;
-
-  const static uint32 sha256_k[];
-  static const unsigned int SHA224_256_BLOCK_SIZE = (512 / 8);
-
-  public:
-  void init();
-  void update(const unsigned char* message, unsigned int len);
-  void final(unsigned char* digest);
-  static const unsigned int DIGEST_SIZE = (256 / 8);
-
-  protected:
-  void transform(const unsigned char* message, unsigned int block_nb);
-  unsigned int m_tot_len;
-  unsigned int m_len;
-  unsigned char m_block[2 * SHA224_256_BLOCK_SIZE];
-  uint32 m_h[8];
+namespace audioLib {
+namespace sharandom {
+namespace {
+struct CacheEntry {
+  long long seed;
+  // values held, 0 for an unused entry
+  std::size_t count;
+  unsigned int last_used;
+  float values[SHARANDOM_CACHE_VALUES];
 };
 
-std::vector<unsigned char> sha256(unsigned char* input, int len);
-
-#define SHA2_SHFR(x, n) (x >> n)
-#define SHA2_ROTR(x, n) ((x >> n) | (x << ((sizeof(x) << 3) - n)))
-#define SHA2_ROTL(x, n) ((x << n) | (x >> ((sizeof(x) << 3) - n)))
-#define SHA2_CH(x, y, z) ((x & y) ^ (~x & z))
-#define SHA2_MAJ(x, y, z) ((x & y) ^ (x & z) ^ (y & z))
-#define SHA256_F1(x) (SHA2_ROTR(x, 2) ^ SHA2_ROTR(x, 13) ^ SHA2_ROTR(x, 22))
-#define SHA256_F2(x) (SHA2_ROTR(x, 6) ^ SHA2_ROTR(x, 11) ^ SHA2_ROTR(x, 25))
-#define SHA256_F3(x) (SHA2_ROTR(x, 7) ^ SHA2_ROTR(x, 18) ^ SHA2_SHFR(x, 3))
-#define SHA256_F4(x) (SHA2_ROTR(x, 17) ^ SHA2_ROTR(x, 19) ^ SHA2_SHFR(x, 10))
-#define SHA2_UNPACK32(x, str)                                                  \
-  {                                                                            \
-    *((str) + 3) = (uint8)((x));                                               \
-    *((str) + 2) = (uint8)((x) >> 8);                                          \
-    *((str) + 1) = (uint8)((x) >> 16);                                         \
-    *((str) + 0) = (uint8)((x) >> 24);                                         \
-  }
-#define SHA2_PACK32(str, x)                                                    \
-  {                                                                            \
-    *(x) = ((uint32) * ((str) + 3)) | ((uint32) * ((str) + 2) << 8) |          \
-           ((uint32) * ((str) + 1) << 16) | ((uint32) * ((str) + 0) << 24);    \
-  }
-
-const unsigned int SHA256::sha256_k[64] = // UL = uint32
-  {0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
-   0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
-   0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
-   0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
-   0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
-   0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
-   0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
-   0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-   0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
-
-void SHA256::transform(const unsigned char* message, unsigned int block_nb) {
-  uint32 w[64];
-  uint32 wv[8];
-  uint32 t1, t2;
-  const unsigned char* sub_block;
-  int i;
-  int j;
-  for (i = 0; i < (int)block_nb; i++) {
-    sub_block = message + (i << 6);
-    for (j = 0; j < 16; j++) {
-      SHA2_PACK32(&sub_block[j << 2], &w[j]);
-    }
-    for (j = 16; j < 64; j++) {
-      w[j] = SHA256_F4(w[j - 2]) + w[j - 7] + SHA256_F3(w[j - 15]) + w[j - 16];
-    }
-    for (j = 0; j < 8; j++) {
-      wv[j] = m_h[j];
-    }
-    for (j = 0; j < 64; j++) {
-      t1 = wv[7] + SHA256_F2(wv[4]) + SHA2_CH(wv[4], wv[5], wv[6]) +
-           sha256_k[j] + w[j];
-      t2 = SHA256_F1(wv[0]) + SHA2_MAJ(wv[0], wv[1], wv[2]);
-      wv[7] = wv[6];
-      wv[6] = wv[5];
-      wv[5] = wv[4];
-      wv[4] = wv[3] + t1;
-      wv[3] = wv[2];
-      wv[2] = wv[1];
-      wv[1] = wv[0];
-      wv[0] = t1 + t2;
-    }
-    for (j = 0; j < 8; j++) {
-      m_h[j] += wv[j];
-    }
-  }
-}
-
-void SHA256::init() {
-  m_h[0] = 0x6a09e667;
-  m_h[1] = 0xbb67ae85;
-  m_h[2] = 0x3c6ef372;
-  m_h[3] = 0xa54ff53a;
-  m_h[4] = 0x510e527f;
-  m_h[5] = 0x9b05688c;
-  m_h[6] = 0x1f83d9ab;
-  m_h[7] = 0x5be0cd19;
-  m_len = 0;
-  m_tot_len = 0;
-}
-
-void SHA256::update(const unsigned char* message, unsigned int len) {
-  unsigned int block_nb;
-  unsigned int new_len, rem_len, tmp_len;
-  const unsigned char* shifted_message;
-  tmp_len = SHA224_256_BLOCK_SIZE - m_len;
-  rem_len = len < tmp_len ? len : tmp_len;
-  memcpy(&m_block[m_len], message, rem_len);
-  if (m_len + len < SHA224_256_BLOCK_SIZE) {
-    m_len += len;
+CacheEntry cache[SHARANDOM_CACHE_ENTRIES];
+unsigned int cache_clock = 0;
+// held while the cache is used, a caller that finds it taken, e.g. the audio
+// thread while the control thread has it, skips the cache rather than wait
+std::atomic_flag cache_busy = ATOMIC_FLAG_INIT;
+} // namespace
+
+void generate(long long seed, float* out, std::size_t count) {
+  if (count > SHARANDOM_CACHE_VALUES ||
+      cache_busy.test_and_set(std::memory_order_acquire)) {
+    expand(seed, out, count);
     return;
   }
-  new_len = len - rem_len;
-  block_nb = new_len / SHA224_256_BLOCK_SIZE;
-  shifted_message = message + rem_len;
-  transform(m_block, 1);
-  transform(shifted_message, block_nb);
-  rem_len = new_len % SHA224_256_BLOCK_SIZE;
-  memcpy(m_block, &shifted_message[block_nb << 6], rem_len);
-  m_len = rem_len;
-  m_tot_len += (block_nb + 1) << 6;
-}
-
-void SHA256::final(unsigned char* digest) {
-  unsigned int block_nb;
-  unsigned int pm_len;
-  unsigned int len_b;
-  int i;
-  block_nb =
-    (1 + ((SHA224_256_BLOCK_SIZE - 9) < (m_len % SHA224_256_BLOCK_SIZE)));
-  len_b = (m_tot_len + m_len) << 3;
-  pm_len = block_nb << 6;
-  memset(m_block + m_len, 0, pm_len - m_len);
-  m_block[m_len] = 0x80;
-  SHA2_UNPACK32(len_b, m_block + pm_len - 4);
-  transform(m_block, block_nb);
-  for (i = 0; i < 8; i++) {
-    SHA2_UNPACK32(m_h[i], &digest[i << 2]);
-  }
-}
-
-std::vector<unsigned char> sha256(unsigned char* input, int len) {
-  unsigned char digest[SHA256::DIGEST_SIZE];
-  memset(digest, 0, SHA256::DIGEST_SIZE);
-
-  SHA256 ctx;
-  ctx.init();
-  ctx.update(input, len);
-  ctx.final(digest);
 
-  std::vector<unsigned char> output;
-  output.assign(digest, digest + SHA256::DIGEST_SIZE);
-  return output;
-}
-
-namespace audioLib {
-namespace sharandom {
-std::vector<float> generate(long long seed, size_t count) {
-  std::vector<unsigned char> byteList;
-  auto iterations = count * sizeof(unsigned int) / (256 / 8) + 1;
-  auto byteArr = (unsigned char*)&seed;
-  std::vector<unsigned char> bytes(byteArr, byteArr + 8);
-
-  for (size_t i = 0; i < iterations; i++) {
-    bytes = sha256(&bytes[0], 8);
-    for (auto b : bytes)
-      byteList.push_back(b);
+  auto oldest = &cache[0];
+  for (auto& entry : cache) {
+    if (entry.count > 0 && entry.seed == seed) {
+      // a longer expansion starts with the shorter one
+      if (entry.count < count) {
+        expand(seed, entry.values, count);
+        entry.count = count;
+      }
+      entry.last_used = ++cache_clock;
+      std::copy(entry.values, entry.values + count, out);
+      cache_busy.clear(std::memory_order_release);
+      return;
+    }
+    if (entry.last_used < oldest->last_used)
+      oldest = &entry;
   }
 
-  auto intArray = (unsigned int*)(&byteList[0]);
-
-  std::vector<float> out;
-  for (size_t i = 0; i < count; i++) {
-    out.push_back((intArray[i] / (float)UINT_MAX));
-  }
-  return out;
+  expand(seed, oldest->values, count);
+  oldest->seed = seed;
+  oldest->count = count;
+  oldest->last_used = ++cache_clock;
+  std::copy(oldest->values, oldest->values + count, out);
+  cache_busy.clear(std::memory_order_release);
 }
 } // namespace sharandom
-} // namespace audioLib
\ No newline at end of file
+} // namespace audioLib
@@ -1,9 +1,156 @@
+/*
+ * Updated to C++, zedwood.com 2012
+ * Based on Olivier Gay's version
+ * See Modified BSD License below:
+ *
+ * FIPS 180-2 SHA-224/256/384/512 implementation
+ * Issue date:  04/30/2005
+ * http://www.ouah.org/ogay/sha2/
+ *
+ * Copyright (C) 2005, 2007 Olivier Gay <olivier.gay@a3.epfl.ch>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
 #pragma once
 
-#include <vector>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+// Values a single cache entry holds, enough for the largest user, the
+// multitap diffuser
+#define SHARANDOM_CACHE_VALUES 100
+#define SHARANDOM_CACHE_ENTRIES 4
 
 namespace audioLib {
 namespace sharandom {
-std::vector<float> generate(long long seed, size_t count);
+namespace detail {
+// SHA-256 round constants
+constexpr std::uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+constexpr std::uint32_t H0[8] = {0x6a09e667,
+                                 0xbb67ae85,
+                                 0x3c6ef372,
+                                 0xa54ff53a,
+                                 0x510e527f,
+                                 0x9b05688c,
+                                 0x1f83d9ab,
+                                 0x5be0cd19};
+
+constexpr std::uint32_t rotr(std::uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+constexpr std::uint32_t bswap(std::uint32_t x) {
+  return (x >> 24) | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) | (x << 24);
+}
+
+struct Digest {
+  std::uint32_t h[8];
+};
+
+/**
+ * SHA-256 of an 8 byte message, given as its two big-endian words. The
+ * message always fits one padded block.
+ */
+constexpr Digest hash8(std::uint32_t w0, std::uint32_t w1) {
+  std::uint32_t w[64] = {w0, w1, 0x80000000};
+  // message length in bits
+  w[15] = 64;
+  for (int j = 16; j < 64; j++) {
+    auto s0 = rotr(w[j - 15], 7) ^ rotr(w[j - 15], 18) ^ (w[j - 15] >> 3);
+    auto s1 = rotr(w[j - 2], 17) ^ rotr(w[j - 2], 19) ^ (w[j - 2] >> 10);
+    w[j] = s1 + w[j - 7] + s0 + w[j - 16];
+  }
+
+  std::uint32_t v[8] = {};
+  for (int j = 0; j < 8; j++)
+    v[j] = H0[j];
+
+  for (int j = 0; j < 64; j++) {
+    auto ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+    auto maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+    auto t1 = v[7] + (rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25)) + ch +
+              K[j] + w[j];
+    auto t2 = (rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22)) + maj;
+    v[7] = v[6];
+    v[6] = v[5];
+    v[5] = v[4];
+    v[4] = v[3] + t1;
+    v[3] = v[2];
+    v[2] = v[1];
+    v[1] = v[0];
+    v[0] = t1 + t2;
+  }
+
+  Digest digest{};
+  for (int j = 0; j < 8; j++)
+    digest.h[j] = H0[j] + v[j];
+  return digest;
+}
+} // namespace detail
+
+/**
+ * Writes `count` values in [0, 1] for `seed` to `out`, without the cache.
+ * Can be evaluated at compile time.
+ *
+ * The seed's little-endian bytes are hashed, then the first 8 bytes of each
+ * digest are hashed again, and the digests are read as little-endian 32 bit
+ * integers. A longer expansion of a seed starts with the shorter ones.
+ */
+constexpr void expand(long long seed, float* out, std::size_t count) {
+  auto bits = (unsigned long long)seed;
+  auto w0 = detail::bswap((std::uint32_t)bits);
+  auto w1 = detail::bswap((std::uint32_t)(bits >> 32));
+
+  std::size_t i = 0;
+  while (i < count) {
+    auto digest = detail::hash8(w0, w1);
+    for (int j = 0; j < 8 && i < count; j++)
+      out[i++] = detail::bswap(digest.h[j]) / (float)UINT_MAX;
+    w0 = digest.h[0];
+    w1 = digest.h[1];
+  }
+}
+
+/**
+ * Writes `count` values in [0, 1] for `seed` to `out`. Never allocates. The
+ * last few seeds are cached, so recalling a seed does not hash it again.
+ */
+void generate(long long seed, float* out, std::size_t count);
 } // namespace sharandom
-} // namespace audioLib
\ No newline at end of file
+} // namespace audioLib
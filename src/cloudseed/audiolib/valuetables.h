@@ -1,24 +1,77 @@
 #pragma once
 
-#include "daisy_petal.h"
+#include <algorithm>
+
+// Points each response is sampled at over the parameter range, Get
+// interpolates between them
+#define RESPONSE_TABLE_SIZE 257
 
 namespace audioLib {
 namespace valueTables {
-const int TableSize = 40001;
+/**
+ * A response sampled at RESPONSE_TABLE_SIZE evenly spaced points over [0, 1].
+ * The tables are worked out at compile time, so they sit in flash and there
+ * is nothing to fill in at boot.
+ */
+struct Table {
+  float values[RESPONSE_TABLE_SIZE];
+};
+
+namespace detail {
+/**
+ * e^y for y >= 0 from its series, whose terms are all positive so nothing
+ * cancels.
+ */
+constexpr double exp(double y) {
+  double sum = 1;
+  double term = 1;
+  for (int n = 1; n < 100; n++) {
+    term *= y / n;
+    sum += term;
+  }
+  return sum;
+}
+
+/**
+ * (base^x - 1) / (base - 1), rising from 0 to 1 over x in [0, 1].
+ */
+constexpr Table response(double log_base) {
+  Table table = {};
+  auto last = RESPONSE_TABLE_SIZE - 1;
+  for (int i = 1; i < last; i++) {
+    double x = (double)i / last;
+    table.values[i] = (exp(x * log_base) - 1) / (exp(log_base) - 1);
+  }
+  table.values[last] = 1;
+  return table;
+}
+
+constexpr double LN_2 = 0.693147180559945309417;
+constexpr double LN_10 = 2.302585092994045684018;
+} // namespace detail
 
-// octave response. value float every step (2,3,4,5 or 6 steps)
-extern DSY_SDRAM_BSS float Response2Oct[TableSize];
-extern DSY_SDRAM_BSS float Response3Oct[TableSize];
-extern DSY_SDRAM_BSS float Response4Oct[TableSize];
-extern DSY_SDRAM_BSS float Response5Oct[TableSize];
-extern DSY_SDRAM_BSS float Response6Oct[TableSize];
+// octave response. value doubles every step (2,3,4,5 or 6 steps)
+extern const Table Response2Oct;
+extern const Table Response3Oct;
+extern const Table Response4Oct;
+extern const Table Response5Oct;
+extern const Table Response6Oct;
 
 // decade response, value multiplies by 10 every step
-extern DSY_SDRAM_BSS float Response2Dec[TableSize];
-extern DSY_SDRAM_BSS float Response3Dec[TableSize];
-extern DSY_SDRAM_BSS float Response4Dec[TableSize];
+extern const Table Response2Dec;
+extern const Table Response3Dec;
+extern const Table Response4Dec;
 
-void Init();
-float Get(float index, float* table);
+/**
+ * The response of `table` at `index` in [0, 1], out of range indices are
+ * clamped.
+ */
+inline float Get(float index, const Table& table) {
+  auto last = RESPONSE_TABLE_SIZE - 1;
+  float x = std::min(std::max(index, 0.0f), 1.0f) * last;
+  int i = std::min((int)x, last - 1);
+  float frac = x - i;
+  return table.values[i] + frac * (table.values[i + 1] - table.values[i]);
+}
 } // namespace valueTables
 } // namespace audioLib
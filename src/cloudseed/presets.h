@@ -1,5 +1,17 @@
+/**
+ * Factory programs from the original Cloud Seed plugin.
+ *
+ * Each program fills a `Parameter::Count` sized array of unscaled parameter
+ * values. LineCount is left untouched, it is driven by the Terrarium switches
+ * (or the caller on host builds).
+ */
+#pragma once
 
-void initFactoryChorus() {
+#include "Parameter.h"
+
+namespace cloudSeed {
+namespace presets {
+inline void initFactoryChorus(float* parameters) {
   // parameters from Chorus Delay in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.0;
@@ -49,13 +61,9 @@ void initFactoryChorus() {
   parameters[(int)Parameter::CutoffEnabled] = 1.0;
   parameters[(int)Parameter::LateStageTap] = 1.0;
   parameters[(int)Parameter::Interpolation] = 0.0;
-
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactoryDullEchos() {
+inline void initFactoryDullEchos(float* parameters) {
   // parameters from Dull Echos in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.0;
@@ -104,13 +112,9 @@ void initFactoryDullEchos() {
   parameters[(int)Parameter::CutoffEnabled] = 1.0;
   parameters[(int)Parameter::LateStageTap] = 0.0;
   parameters[(int)Parameter::Interpolation] = 1.0;
-
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactoryHyperplane() {
+inline void initFactoryHyperplane(float* parameters) {
   // parameters from Hyperplane in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.1549999862909317;
@@ -159,13 +163,9 @@ void initFactoryHyperplane() {
   parameters[(int)Parameter::CutoffEnabled] = 1.0;
   parameters[(int)Parameter::LateStageTap] = 1.0;
   parameters[(int)Parameter::Interpolation] = 0.0;
-
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactoryMediumSpace() {
+inline void initFactoryMediumSpace(float* parameters) {
   // parameters from Medium Space in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.0;
@@ -214,13 +214,9 @@ void initFactoryMediumSpace() {
   parameters[(int)Parameter::CutoffEnabled] = 1.0;
   parameters[(int)Parameter::LateStageTap] = 1.0;
   parameters[(int)Parameter::Interpolation] = 1.0;
-
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactoryNoiseInTheHallway() {
+inline void initFactoryNoiseInTheHallway(float* parameters) {
   // parameters from Noise In The Hallway in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.0;
@@ -269,13 +265,9 @@ void initFactoryNoiseInTheHallway() {
   parameters[(int)Parameter::CutoffEnabled] = 0.0;
   parameters[(int)Parameter::LateStageTap] = 0.0;
   parameters[(int)Parameter::Interpolation] = 1.0;
-
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactoryRubiKaFields() {
+inline void initFactoryRubiKaFields(float* parameters) {
   // parameters from Rubi-Ka Fields in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.32499998807907104;
@@ -324,13 +316,9 @@ void initFactoryRubiKaFields() {
   parameters[(int)Parameter::CutoffEnabled] = 1.0;
   parameters[(int)Parameter::LateStageTap] = 1.0;
   parameters[(int)Parameter::Interpolation] = 0.0;
-
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactorySmallRoom() {
+inline void initFactorySmallRoom(float* parameters) {
   // parameters from Small Room in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.0;
@@ -379,12 +367,9 @@ void initFactorySmallRoom() {
   parameters[(int)Parameter::CutoffEnabled] = 0.0;
   parameters[(int)Parameter::LateStageTap] = 1.0;
   parameters[(int)Parameter::Interpolation] = 1.0;
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactory90sAreBack() {
+inline void initFactory90sAreBack(float* parameters) {
   // parameters from The 90s Are Back in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0;
@@ -433,12 +418,9 @@ void initFactory90sAreBack() {
   parameters[(int)Parameter::CutoffEnabled] = 0;
   parameters[(int)Parameter::LateStageTap] = 1;
   parameters[(int)Parameter::Interpolation] = 1;
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
 
-void initFactoryThroughTheLookingGlass() {
+inline void initFactoryThroughTheLookingGlass(float* parameters) {
   // parameters from Through The Looking Glass in
   // https://github.com/ValdemarOrn/CloudSeed/tree/master/Factory%20Programs
   parameters[(int)Parameter::InputMix] = 0.0;
@@ -487,7 +469,25 @@ void initFactoryThroughTheLookingGlass() {
   parameters[(int)Parameter::CutoffEnabled] = 1.0;
   parameters[(int)Parameter::LateStageTap] = 1.0;
   parameters[(int)Parameter::Interpolation] = 1.0;
-  for (auto value = 0; value < (int)Parameter::Count; value++) {
-    setParameter((Parameter)value, parameters[value]);
-  }
 }
+
+struct FactoryProgram {
+  const char* name;
+  void (*init)(float* parameters);
+};
+
+#define FACTORY_PROGRAM_COUNT 9
+
+static const FactoryProgram FACTORY_PROGRAMS[FACTORY_PROGRAM_COUNT] = {
+  {"Chorus Delay", initFactoryChorus},
+  {"Dull Echos", initFactoryDullEchos},
+  {"Hyperplane", initFactoryHyperplane},
+  {"Medium Space", initFactoryMediumSpace},
+  {"Noise In The Hallway", initFactoryNoiseInTheHallway},
+  {"Rubi-Ka Fields", initFactoryRubiKaFields},
+  {"Small Room", initFactorySmallRoom},
+  {"The 90s Are Back", initFactory90sAreBack},
+  {"Through The Looking Glass", initFactoryThroughTheLookingGlass},
+};
+} // namespace presets
+} // namespace cloudSeed
@@ -1,4 +1,4 @@
 #pragma once
 
-#define BATCH_SIZE 4
-#define MCU_CLOCK_RATE 48000 // sample rate in Hz
\ No newline at end of file
+#define BATCH_SIZE 4         // default audio block size, as run on the pedal
+#define MCU_CLOCK_RATE 48000 // default sample rate in Hz, as run on the pedal
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "allocator.hpp"
+
+static bool aligned(void* pointer, size_t alignment) {
+  return reinterpret_cast<std::uintptr_t>(pointer) % alignment == 0;
+}
+
+TEST(ArenaTest, AllocationsAreAligned) {
+  alignas(128) static char memory[4096];
+  // an unaligned block still hands out aligned addresses
+  Arena arena(memory + 3, sizeof(memory) - 3);
+
+  auto a = arena.allocate(5, "a");
+  auto b = arena.allocate(7, "b");
+  auto c = arena.allocate(1, "c", 128);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  ASSERT_NE(c, nullptr);
+  EXPECT_TRUE(aligned(a, ARENA_ALIGNMENT));
+  EXPECT_TRUE(aligned(b, ARENA_ALIGNMENT));
+  EXPECT_TRUE(aligned(c, 128));
+  EXPECT_GE(static_cast<char*>(b) - static_cast<char*>(a), 5);
+}
+
+TEST(ArenaTest, UsageIsSummedByTag) {
+  alignas(ARENA_ALIGNMENT) static char memory[4096];
+  Arena arena(memory, sizeof(memory));
+  arena.allocate(100, "delay");
+  arena.allocate(10, "lfo");
+  arena.allocate(50, "delay");
+
+  Arena::TagUsage usage[4];
+  ASSERT_EQ(arena.usageByTag(usage, 4), 2u);
+  EXPECT_STREQ(usage[0].tag, "delay");
+  EXPECT_EQ(usage[0].bytes, 150u);
+  EXPECT_EQ(usage[0].count, 2u);
+  EXPECT_STREQ(usage[1].tag, "lfo");
+  EXPECT_EQ(usage[1].bytes, 10u);
+
+  // only the first tags are written, all are counted
+  EXPECT_EQ(arena.usageByTag(usage, 1), 2u);
+  EXPECT_EQ(arena.recordCount(), 3u);
+  EXPECT_EQ(arena.record(2).bytes, 50u);
+}
+
+TEST(ArenaTest, RewindReleasesLaterAllocations) {
+  alignas(ARENA_ALIGNMENT) static char memory[4096];
+  Arena arena(memory, sizeof(memory));
+  auto first = arena.allocate(100, "kept");
+  auto mark = arena.mark();
+  arena.allocate(1000, "released");
+  arena.allocate(1000, "released");
+  auto high_water = arena.used();
+  EXPECT_EQ(arena.remaining(), arena.capacity() - arena.used());
+
+  arena.rewind(mark);
+  EXPECT_EQ(arena.used(), mark);
+  EXPECT_EQ(arena.highWaterMark(), high_water);
+  EXPECT_EQ(arena.recordCount(), 1u);
+
+  // the released memory is handed out again
+  auto again = arena.allocate(10, "again");
+  EXPECT_EQ(static_cast<char*>(again) - static_cast<char*>(first),
+            (std::ptrdiff_t)ARENA_ALIGNMENT * 2);
+
+  arena.reset();
+  EXPECT_EQ(arena.used(), 0u);
+  EXPECT_EQ(arena.recordCount(), 0u);
+  EXPECT_EQ(arena.allocate(10, "first"), first);
+}
+
+static const char* failed_tag = nullptr;
+static size_t failed_bytes = 0;
+
+TEST(ArenaTest, FailuresAreReported) {
+  alignas(ARENA_ALIGNMENT) static char memory[256];
+  Arena arena(memory, sizeof(memory), [](const char* tag, size_t bytes) {
+    failed_tag = tag;
+    failed_bytes = bytes;
+  });
+
+  EXPECT_NE(arena.allocate(200, "fits"), nullptr);
+  EXPECT_EQ(arena.allocate(100, "too big"), nullptr);
+  EXPECT_STREQ(failed_tag, "too big");
+  EXPECT_EQ(failed_bytes, 100u);
+  EXPECT_EQ(arena.failures(), 1u);
+  // a failure allocates nothing
+  EXPECT_EQ(arena.used(), 200u);
+  EXPECT_EQ(arena.recordCount(), 1u);
+
+  Arena empty;
+  EXPECT_EQ(empty.allocate(1, "none"), nullptr);
+  EXPECT_EQ(empty.failures(), 1u);
+}
+
+TEST(ArenaTest, AllocationsPastTheRecordsAreCounted) {
+  alignas(ARENA_ALIGNMENT) static char
+    memory[ARENA_ALIGNMENT * (ARENA_MAX_RECORDS + 8)];
+  Arena arena(memory, sizeof(memory));
+  for (size_t i = 0; i < ARENA_MAX_RECORDS + 4; i++)
+    ASSERT_NE(arena.allocate(8, "small"), nullptr);
+
+  Arena::TagUsage usage[2];
+  ASSERT_EQ(arena.usageByTag(usage, 2), 2u);
+  EXPECT_EQ(usage[0].count, (size_t)ARENA_MAX_RECORDS);
+  EXPECT_STREQ(usage[1].tag, ARENA_UNRECORDED_TAG);
+  EXPECT_EQ(usage[1].count, 4u);
+  EXPECT_EQ(usage[1].bytes, 32u);
+
+  arena.rewind(arena.record(10).offset);
+  EXPECT_EQ(arena.usageByTag(usage, 2), 1u);
+  EXPECT_EQ(usage[0].count, 10u);
+}
+
+TEST(ArenaTest, FastAllocationsFallBackToBulk) {
+  alignas(ARENA_ALIGNMENT) static char fast_memory[ARENA_ALIGNMENT * 4];
+  alignas(ARENA_ALIGNMENT) static char bulk_memory[4096];
+  Arena fast(fast_memory, sizeof(fast_memory));
+  Arena bulk(bulk_memory, sizeof(bulk_memory));
+
+  auto in_fast = [&](void* pointer) {
+    auto bytes = static_cast<char*>(pointer);
+    return bytes >= fast_memory && bytes < fast_memory + sizeof(fast_memory);
+  };
+  auto a = placeAllocation(fast, bulk, ARENA_ALIGNMENT, "a", MemoryTier::Fast);
+  auto b = placeAllocation(fast, bulk, 16, "b", MemoryTier::Bulk);
+  auto c = placeAllocation(
+    fast, bulk, ARENA_ALIGNMENT * 4, "c", MemoryTier::Fast);
+  // a later, smaller one still fits
+  auto d = placeAllocation(fast, bulk, 16, "d", MemoryTier::Fast);
+  EXPECT_TRUE(in_fast(a));
+  EXPECT_FALSE(in_fast(b));
+  EXPECT_FALSE(in_fast(c));
+  EXPECT_TRUE(in_fast(d));
+
+  EXPECT_EQ(fast.failures(), 1u);
+  EXPECT_EQ(fast.failedBytes(), (size_t)ARENA_ALIGNMENT * 4);
+  EXPECT_EQ(bulk.recordCount(), 2u);
+  EXPECT_STREQ(bulk.record(1).tag, "c");
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cloudseed/BufferClearer.h"
+
+using cloudSeed::BufferClearer;
+
+TEST(BufferClearerTest, StepsStayWithinTheBudget) {
+  std::vector<char> memory(5000, 1);
+  BufferClearer clearer;
+  EXPECT_FALSE(clearer.isBusy());
+
+  clearer.add(memory.data(), 1000);
+  clearer.add(memory.data() + 1500, 3000);
+  // queued again, cleared once
+  clearer.add(memory.data(), 1000);
+  EXPECT_EQ(4000u, clearer.pendingBytes());
+
+  size_t steps = 0;
+  while (clearer.isBusy()) {
+    auto pending = clearer.pendingBytes();
+    clearer.step(1024);
+    EXPECT_EQ(pending - std::min(pending, (size_t)1024),
+              clearer.pendingBytes());
+    steps++;
+  }
+  EXPECT_EQ(4u, steps);
+
+  for (size_t i = 0; i < memory.size(); i++) {
+    bool queued = i < 1000 || (i >= 1500 && i < 4500);
+    ASSERT_EQ(queued ? 0 : 1, memory[i]) << i;
+  }
+}
+
+TEST(BufferClearerTest, FinishClearsEverything) {
+  std::vector<float> a(300, 1.0f);
+  std::vector<float> b(7, 1.0f);
+  BufferClearer clearer;
+  clearer.add(a.data(), a.size() * sizeof(float));
+  clearer.step(10);
+  clearer.add(b.data(), b.size() * sizeof(float));
+  clearer.finish();
+
+  EXPECT_FALSE(clearer.isBusy());
+  EXPECT_EQ(0u, clearer.pendingBytes());
+  for (auto sample : a)
+    ASSERT_EQ(0.0f, sample);
+  for (auto sample : b)
+    ASSERT_EQ(0.0f, sample);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "cloudseed/DelayBuffer.h"
+
+using cloudSeed::storage::Float16;
+using cloudSeed::storage::Int16;
+
+TEST(DelayBufferTest, Float16KeepsRepresentableValues) {
+  const float values[] = {0.0f, 1.0f, -1.0f, 0.5f, 2048.0f, 65504.0f,
+                          -0.333251953125f, 6.103515625e-05f,
+                          // subnormal halves
+                          5.960464477539063e-08f, -3.0517578125e-05f};
+  for (auto value : values)
+    EXPECT_EQ(value, Float16::decode(Float16::encode(value))) << value;
+}
+
+TEST(DelayBufferTest, Float16RoundsToNearest) {
+  for (float value = -4.0f; value < 4.0f; value += 0.000123f) {
+    auto decoded = Float16::decode(Float16::encode(value));
+    // half a unit in the last place of an 11 bit mantissa, fixed below the
+    // smallest normal half
+    auto ulp = std::ldexp(1.0f, std::max(std::ilogb(value), -14) - 10);
+    EXPECT_LE(std::fabs(decoded - value), ulp / 2) << value;
+  }
+}
+
+TEST(DelayBufferTest, Float16SaturatesToInfinity) {
+  EXPECT_TRUE(std::isinf(Float16::decode(Float16::encode(1e6f))));
+  EXPECT_TRUE(std::isinf(Float16::decode(Float16::encode(-1e6f))));
+}
+
+TEST(DelayBufferTest, Int16RoundTrip) {
+  auto step = INT16_STORAGE_HEADROOM / 32767.0f;
+  for (float value = -INT16_STORAGE_HEADROOM; value <= INT16_STORAGE_HEADROOM;
+       value += 0.001f) {
+    EXPECT_NEAR(value, Int16::decode(Int16::encode(value)), step / 2 + 1e-6f)
+      << value;
+  }
+}
+
+TEST(DelayBufferTest, Int16Clips) {
+  EXPECT_EQ(32767, Int16::encode(INT16_STORAGE_HEADROOM * 2));
+  EXPECT_EQ(-32767, Int16::encode(-INT16_STORAGE_HEADROOM * 2));
+}
+
+TEST(DelayBufferTest, CompactFormatsHalveTheMemory) {
+  cloudSeed::DelayBuffer full(48000, cloudSeed::SampleFormat::Float32);
+  cloudSeed::DelayBuffer half(48000, cloudSeed::SampleFormat::Float16);
+  cloudSeed::DelayBuffer int16(1024, cloudSeed::SampleFormat::Int16, 1);
+  EXPECT_EQ(65536 * sizeof(float), full.getBytes());
+  EXPECT_EQ(65536 * sizeof(uint16_t), half.getBytes());
+  // the guard sample is padded to keep the pool word aligned
+  EXPECT_EQ(1026 * sizeof(uint16_t), int16.getBytes());
+}
+
+TEST(DelayBufferTest, RoundsUpToPowerOfTwo) {
+  cloudSeed::DelayBuffer exact(4096, cloudSeed::SampleFormat::Float32);
+  cloudSeed::DelayBuffer rounded(7200, cloudSeed::SampleFormat::Float32);
+  EXPECT_EQ(4096u, exact.size());
+  EXPECT_EQ(8192u, rounded.size());
+  EXPECT_EQ(8191u, rounded.getMask());
+}
+
+TEST(DelayBufferTest, GuardMirrorsTheStart) {
+  using cloudSeed::storage::Float32;
+  cloudSeed::DelayBuffer buffer(16, cloudSeed::SampleFormat::Float32, 2);
+  buffer.clear();
+  buffer.write<Float32>(0, 1.0f);
+  buffer.write<Float32>(1, 2.0f);
+  buffer.write<Float32>(15, 3.0f);
+
+  auto data = buffer.data<Float32>();
+  EXPECT_EQ(3.0f, data[15]);
+  EXPECT_EQ(1.0f, data[16]);
+  EXPECT_EQ(2.0f, data[17]);
+  // negative indices wrap through the mask
+  EXPECT_EQ(3.0f, buffer.read((size_t)0 - 1));
+}
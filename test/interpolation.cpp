@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "cloudseed/DelayBuffer.h"
+#include "cloudseed/Interpolation.h"
+
+using cloudSeed::FractionalDelay;
+using cloudSeed::Interpolation;
+using cloudSeed::storage::Float32;
+
+static const Interpolation KERNELS[] = {
+  Interpolation::None,
+  Interpolation::Linear,
+  Interpolation::Hermite,
+  Interpolation::Allpass,
+};
+
+/**
+ * Delays `signal` by `delay` samples with `kernel`, returning the outputs
+ * from `start` on.
+ */
+static std::vector<float> delayed(const std::vector<float>& signal,
+                                  Interpolation kernel,
+                                  float delay,
+                                  size_t start) {
+  FractionalDelay fractional;
+  fractional.set(kernel, delay);
+  auto oldest = fractional.getDelay() + 2;
+
+  std::vector<float> output(signal.size() - start);
+  fractional.read<Float32>(
+    signal.data() + start - oldest, output.data(), output.size());
+  return output;
+}
+
+TEST(InterpolationTest, WholeDelaysAreExact) {
+  std::vector<float> signal(256);
+  for (size_t i = 0; i < signal.size(); i++)
+    signal[i] = std::sin(i * 0.37f) + 0.1f * i;
+
+  for (auto kernel : KERNELS) {
+    auto output = delayed(signal, kernel, 5, 16);
+    for (size_t i = 0; i < output.size(); i++)
+      ASSERT_FLOAT_EQ(signal[16 + i - 5], output[i]) << (int)kernel;
+  }
+}
+
+TEST(InterpolationTest, RampsAreDelayedByTheFraction) {
+  std::vector<float> ramp(256);
+  for (size_t i = 0; i < ramp.size(); i++)
+    ramp[i] = i;
+
+  for (auto kernel : {Interpolation::Linear, Interpolation::Hermite}) {
+    auto output = delayed(ramp, kernel, 7.25f, 16);
+    for (size_t i = 0; i < output.size(); i++)
+      ASSERT_NEAR(16 + i - 7.25f, output[i], 1e-4) << (int)kernel;
+  }
+
+  // the allpass only settles on the fraction
+  auto output = delayed(ramp, Interpolation::Allpass, 7.25f, 16);
+  EXPECT_NEAR(ramp.size() - 1 - 7.25f, output.back(), 1e-3);
+}
+
+TEST(InterpolationTest, HermiteIsCloserThanLinear) {
+  std::vector<float> sine(1024);
+  const float w = 2 * M_PI * 0.05;
+  for (size_t i = 0; i < sine.size(); i++)
+    sine[i] = std::sin(w * i);
+
+  float errors[4] = {};
+  for (auto kernel : KERNELS) {
+    auto output = delayed(sine, kernel, 3.5f, 512);
+    // past the allpass settling
+    for (size_t i = 32; i < output.size(); i++) {
+      auto expected = std::sin(w * (512 + i - 3.5f));
+      auto error = std::fabs(expected - output[i]);
+      errors[(int)kernel] = std::max(errors[(int)kernel], error);
+    }
+  }
+
+  EXPECT_LT(errors[(int)Interpolation::Linear],
+            errors[(int)Interpolation::None]);
+  EXPECT_LT(errors[(int)Interpolation::Hermite],
+            errors[(int)Interpolation::Linear] / 4);
+  EXPECT_LT(errors[(int)Interpolation::Allpass], 0.01);
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "cloudseed/LfoBank.h"
+
+using cloudSeed::LfoBank;
+
+TEST(LfoBankTest, SineMatchesLibrary) {
+  for (float phase = 0.0f; phase < 1.0f; phase += 0.0001f) {
+    EXPECT_NEAR(std::sin(2 * M_PI * phase), LfoBank::sine(phase), 1e-5)
+      << phase;
+  }
+}
+
+TEST(LfoBankTest, SeedDecidesStartingPhase) {
+  LfoBank a(4, 16, 7);
+  LfoBank b(4, 16, 7);
+  LfoBank c(4, 16, 8);
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT_EQ(a.getCurrent(a.add()), b.getCurrent(b.add()));
+    EXPECT_NE(a.getCurrent(i), c.getCurrent(c.add()));
+  }
+}
+
+/**
+ * Ticks `lfo` over `total` samples in blocks of `block` and returns the value
+ * of slot 0 at every update point.
+ */
+static std::vector<float> collect(LfoBank& lfo, size_t total, size_t block) {
+  std::vector<float> values;
+  for (size_t done = 0; done < total; done += block) {
+    lfo.tick(block);
+    size_t update = 0;
+    for (auto i = lfo.getFirstUpdate(); i < block;
+         i += lfo.getUpdateInterval())
+      values.push_back(lfo.getValue(update++, 0));
+  }
+  return values;
+}
+
+TEST(LfoBankTest, UpdatesDoNotDependOnBlockSize) {
+  for (size_t interval : {1, 3, 8, 64}) {
+    LfoBank whole(1, 96, 1);
+    LfoBank chunked(1, 96, 1);
+    whole.setRate(whole.add(), 0.001f);
+    chunked.setRate(chunked.add(), 0.001f);
+    whole.setUpdateInterval(interval);
+    chunked.setUpdateInterval(interval);
+
+    auto expected = collect(whole, 96 * 20, 96);
+    auto actual = collect(chunked, 96 * 20, 5);
+    ASSERT_EQ(expected.size(), actual.size()) << interval;
+    for (size_t i = 0; i < expected.size(); i++)
+      ASSERT_FLOAT_EQ(expected[i], actual[i]) << interval << " " << i;
+  }
+}
+
+TEST(LfoBankTest, RateIsInCyclesPerSample) {
+  LfoBank lfo(1, 10, 1);
+  auto slot = lfo.add();
+  lfo.setRate(slot, 1.0f / 80);
+  auto start = lfo.getCurrent(slot);
+
+  // one full cycle, up to and including the update point on sample 80
+  for (int i = 0; i < 9; i++)
+    lfo.tick(9);
+  EXPECT_NEAR(start, lfo.getCurrent(slot), 1e-4);
+
+  // half a cycle
+  for (int i = 0; i < 5; i++)
+    lfo.tick(8);
+  EXPECT_NEAR(-start, lfo.getCurrent(slot), 1e-4);
+}
+
+TEST(LfoBankTest, SkipStepsLikeTick) {
+  LfoBank ticked(2, 64, 3);
+  LfoBank skipped(2, 64, 3);
+  for (auto lfo : {&ticked, &skipped}) {
+    lfo->setRate(lfo->add(), 0.0013f);
+    lfo->setRate(lfo->add(), 0.00071f);
+    lfo->setUpdateInterval(6);
+  }
+
+  // block sizes that leave the update points at every offset
+  size_t blocks[] = {64, 5, 13, 64, 1, 6, 64, 37};
+  for (auto len : blocks) {
+    ticked.tick(len);
+    skipped.skip(len);
+  }
+  for (size_t slot = 0; slot < 2; slot++)
+    EXPECT_EQ(skipped.getCurrent(slot), ticked.getCurrent(slot));
+
+  ticked.tick(64);
+  skipped.tick(64);
+  EXPECT_EQ(skipped.getFirstUpdate(), ticked.getFirstUpdate());
+  EXPECT_EQ(skipped.getValue(0, 1), ticked.getValue(0, 1));
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "cloudseed/LineControl.h"
+
+using cloudSeed::LineControl;
+using cloudSeed::LineSettings;
+
+TEST(LineControlTest, NothingIsPublishedUntilAParameterChanges) {
+  LineControl control(3, 48000);
+  LineSettings lines[3] = {};
+  EXPECT_FALSE(control.update());
+  EXPECT_FALSE(control.consume(lines));
+
+  control.setDelay(100);
+  EXPECT_TRUE(control.update());
+  EXPECT_TRUE(control.consume(lines));
+  EXPECT_FALSE(control.consume(lines));
+  EXPECT_FALSE(control.update());
+}
+
+TEST(LineControlTest, ChangesAreCoalesced) {
+  LineControl control(3, 48000);
+  LineSettings lines[3] = {};
+  control.setDecay(2);
+  for (int ms = 1; ms <= 100; ms++)
+    control.setDelay(ms);
+  EXPECT_TRUE(control.update());
+  EXPECT_FALSE(control.update());
+  ASSERT_TRUE(control.consume(lines));
+
+  // the spread of the lines is 0.5 to 1.5 times the delay
+  for (auto& line : lines) {
+    EXPECT_GE(line.delay, 4800 / 2);
+    EXPECT_LE(line.delay, 4800 * 3 / 2);
+    EXPECT_GT(line.feedback, 0);
+    EXPECT_LT(line.feedback, 1);
+  }
+}
+
+TEST(LineControlTest, UnconsumedSettingsAreNotOverwritten) {
+  LineControl control(3, 48000);
+  LineSettings lines[3] = {};
+  control.setDecay(2);
+  control.setDelay(100);
+  ASSERT_TRUE(control.update());
+
+  // the audio thread has not taken the first settings yet
+  control.setDelay(200);
+  EXPECT_FALSE(control.update());
+  ASSERT_TRUE(control.consume(lines));
+  auto first = lines[0].delay;
+
+  // the change is kept and published on the next update
+  ASSERT_TRUE(control.update());
+  ASSERT_TRUE(control.consume(lines));
+  EXPECT_NEAR(first * 2, lines[0].delay, 1);
+}
+
+TEST(LineControlTest, SeedSpreadsTheLines) {
+  LineControl a(3, 48000);
+  LineControl b(3, 48000);
+  LineSettings lines_a[3] = {};
+  LineSettings lines_b[3] = {};
+  for (auto control : {&a, &b}) {
+    control->setDecay(2);
+    control->setDelay(100);
+  }
+  b.setSeed(42);
+
+  a.update();
+  b.update();
+  a.consume(lines_a);
+  b.consume(lines_b);
+  EXPECT_NE(lines_a[0].delay, lines_b[0].delay);
+  EXPECT_NE(lines_a[0].delay, lines_a[1].delay);
+}
+
+TEST(LineControlTest, SettingsAreNeverTorn) {
+  // the settings each delay leads to
+  LineSettings short_lines[3] = {};
+  LineSettings long_lines[3] = {};
+  {
+    LineControl control(3, 48000);
+    control.setDecay(2);
+    control.setDelay(100);
+    control.update();
+    control.consume(short_lines);
+    control.setDelay(200);
+    control.update();
+    control.consume(long_lines);
+  }
+
+  LineControl control(3, 48000);
+  control.setDecay(2);
+  control.setDelay(100);
+  std::atomic<bool> done(false);
+  std::thread updater([&]() {
+    while (!done.load()) {
+      control.update();
+      std::this_thread::yield();
+    }
+  });
+
+  size_t consumed = 0;
+  size_t torn = 0;
+  for (int i = 0; i < 100000 && consumed < 1000; i++) {
+    control.setDelay(i % 2 ? 200 : 100);
+    LineSettings lines[3] = {};
+    if (!control.consume(lines)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    consumed++;
+    auto& expected = lines[0].delay == short_lines[0].delay ? short_lines
+                                                            : long_lines;
+    for (size_t j = 0; j < 3; j++) {
+      if (expected[j].delay != lines[j].delay ||
+          expected[j].feedback != lines[j].feedback)
+        torn++;
+    }
+  }
+  done.store(true);
+  updater.join();
+
+  EXPECT_GT(consumed, 0u);
+  EXPECT_EQ(0u, torn);
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "cloudseed/LineFilterBank.h"
+#include "daisysp.h"
+
+using namespace cloudSeed;
+
+#define TEST_LINES 5
+#define TEST_BLOCK 64
+
+static std::vector<float> noise(size_t len, std::uint32_t seed) {
+  std::vector<float> samples(len);
+  for (auto& sample : samples) {
+    seed = seed * 1664525 + 1013904223;
+    sample = (seed >> 8) / (float)(1 << 24) - 0.5f;
+  }
+  return samples;
+}
+
+/**
+ * The filter settings a bank and its references are given.
+ */
+struct Settings {
+  bool low_shelf;
+  bool high_shelf;
+  bool cutoff;
+  int sample_rate;
+  float low_shelf_frequency;
+  float high_shelf_frequency;
+  float cutoff_frequency;
+};
+
+static audioLib::Biquad makeShelf(audioLib::Biquad::FilterType type,
+                                  int sample_rate,
+                                  float frequency) {
+  audioLib::Biquad shelf(type, sample_rate);
+  shelf.kslope = 1.0;
+  shelf.kfrequency = frequency;
+  shelf.setGainDb(-6);
+  shelf.update();
+  return shelf;
+}
+
+static void configure(LineFilterBank& bank, const Settings& settings) {
+  bank.klow_shelf_enabled = settings.low_shelf;
+  bank.khigh_shelf_enabled = settings.high_shelf;
+  bank.kcutoff_enabled = settings.cutoff;
+  // as Biquad::setGainDb(-6) works it out
+  float gain = std::pow(10, -6.0f / 20);
+  bank.setLowShelfFrequency(settings.low_shelf_frequency);
+  bank.setLowShelfGain(gain);
+  bank.setHighShelfFrequency(settings.high_shelf_frequency);
+  bank.setHighShelfGain(gain);
+  bank.setCutoffFrequency(settings.cutoff_frequency);
+  bank.clearBuffers();
+}
+
+/**
+ * Runs `inputs` through `bank` in blocks of uneven length, continuing the
+ * filter state across them.
+ */
+static std::vector<std::vector<float>>
+runBank(LineFilterBank& bank, const std::vector<std::vector<float>>& inputs) {
+  std::vector<std::vector<float>> outputs(
+    inputs.size(), std::vector<float>(inputs[0].size()));
+  const size_t blocks[] = {TEST_BLOCK, 1, 37, 4};
+  size_t done = 0;
+  for (size_t b = 0; done < inputs[0].size(); b++) {
+    auto len = std::min(blocks[b % 4], inputs[0].size() - done);
+    const float* in[TEST_LINES];
+    float* out[TEST_LINES];
+    for (size_t k = 0; k < inputs.size(); k++) {
+      in[k] = &inputs[k][done];
+      out[k] = &outputs[k][done];
+    }
+    bank.filter(in, out, inputs.size(), len);
+    done += len;
+  }
+  return outputs;
+}
+
+/**
+ * One line through the same sections as the bank, scalar and in the same
+ * order of operations.
+ */
+struct ScalarLine {
+  float coefficients[2][5];
+  float state[2][2];
+  size_t shelves;
+  bool cutoff;
+  float cutoff_gain;
+  float cutoff_feedback;
+  float cutoff_state;
+
+  explicit ScalarLine(const Settings& settings)
+    : state(), shelves(0), cutoff(settings.cutoff), cutoff_state(0) {
+    auto add = [&](audioLib::Biquad shelf) {
+      auto a = shelf.getA();
+      auto b = shelf.getB();
+      float section[5] = {b[0], b[1], b[2], a[1], a[2]};
+      std::copy(section, section + 5, coefficients[shelves++]);
+    };
+    if (settings.low_shelf) {
+      add(makeShelf(audioLib::Biquad::FilterType::LowShelf,
+                    settings.sample_rate,
+                    settings.low_shelf_frequency));
+    }
+    if (settings.high_shelf) {
+      add(makeShelf(audioLib::Biquad::FilterType::HighShelf,
+                    settings.sample_rate,
+                    settings.high_shelf_frequency));
+    }
+    auto b = 2.0f - std::cos(2.0f * (float)M_PI * settings.cutoff_frequency /
+                             settings.sample_rate);
+    cutoff_feedback = b - std::sqrt(b * b - 1.0f);
+    cutoff_gain = 1.0f - cutoff_feedback;
+  }
+
+  float tick(float x) {
+    for (size_t k = 0; k < shelves; k++) {
+      auto c = coefficients[k];
+      float y = c[0] * x + state[k][0];
+      state[k][0] = c[1] * x - c[3] * y + state[k][1];
+      state[k][1] = c[2] * x - c[4] * y;
+      x = y;
+    }
+    if (cutoff) {
+      cutoff_state = cutoff_gain * x + cutoff_feedback * cutoff_state;
+      x = cutoff_state;
+    }
+    return x;
+  }
+};
+
+TEST(LineFilterBankTest, LanesMatchScalarLines) {
+  auto& fast = fastArena();
+  auto fast_mark = fast.mark();
+  {
+    LineFilterBank bank(TEST_LINES, 48000, TEST_BLOCK);
+    Settings settings = {true, true, true, 48000, 200, 6000, 3000};
+    configure(bank, settings);
+
+    // fewer lines than a lane group, exactly one and more than one
+    for (size_t line_count = 1; line_count <= TEST_LINES; line_count++) {
+      std::vector<std::vector<float>> inputs;
+      for (size_t k = 0; k < line_count; k++)
+        inputs.push_back(noise(1000, k + 1));
+      bank.clearBuffers();
+      auto outputs = runBank(bank, inputs);
+
+      for (size_t k = 0; k < line_count; k++) {
+        ScalarLine line(settings);
+        for (size_t i = 0; i < inputs[k].size(); i++) {
+          ASSERT_FLOAT_EQ(outputs[k][i], line.tick(inputs[k][i]))
+            << line_count << " lines, line " << k << " at " << i
+            << ", lane width " << LINE_LANE_WIDTH;
+        }
+      }
+    }
+  }
+  fast.rewind(fast_mark);
+}
+
+/**
+ * Checks a bank against the direct form I shelves of audioLib::Biquad and
+ * the daisysp::Tone the cutoff stands in for, within 1e-5 of the unit input.
+ */
+static void expectMatchesReference(const Settings& settings) {
+  auto& fast = fastArena();
+  auto fast_mark = fast.mark();
+  {
+    LineFilterBank bank(2, settings.sample_rate, TEST_BLOCK);
+    configure(bank, settings);
+    std::vector<std::vector<float>> inputs = {noise(4000, 7), noise(4000, 8)};
+    auto outputs = runBank(bank, inputs);
+
+    // the clamp keeps a reference past the Nyquist frequency from folding
+    auto nyquist = 0.49f * settings.sample_rate;
+    for (size_t k = 0; k < inputs.size(); k++) {
+      auto low_shelf =
+        makeShelf(audioLib::Biquad::FilterType::LowShelf,
+                  settings.sample_rate,
+                  std::min(settings.low_shelf_frequency, nyquist));
+      auto high_shelf =
+        makeShelf(audioLib::Biquad::FilterType::HighShelf,
+                  settings.sample_rate,
+                  std::min(settings.high_shelf_frequency, nyquist));
+      daisysp::Tone cutoff;
+      cutoff.Init(settings.sample_rate);
+      float cutoff_frequency = std::min(settings.cutoff_frequency, nyquist);
+      cutoff.SetFreq(cutoff_frequency);
+
+      for (size_t i = 0; i < inputs[k].size(); i++) {
+        float expected = inputs[k][i];
+        if (settings.low_shelf)
+          expected = low_shelf.tick(expected);
+        if (settings.high_shelf)
+          expected = high_shelf.tick(expected);
+        if (settings.cutoff)
+          expected = cutoff.Process(expected);
+        ASSERT_TRUE(std::isfinite(outputs[k][i]));
+        ASSERT_NEAR(outputs[k][i], expected, 1e-5f)
+          << "low shelf " << settings.low_shelf << ", high shelf "
+          << settings.high_shelf << ", cutoff " << settings.cutoff
+          << " at " << settings.sample_rate << " Hz, line " << k << " at "
+          << i;
+      }
+    }
+  }
+  fast.rewind(fast_mark);
+}
+
+TEST(LineFilterBankTest, CascadeMatchesTheSeparateFilters) {
+  for (int enabled = 0; enabled < 8; enabled++) {
+    expectMatchesReference({(enabled & 1) != 0,
+                            (enabled & 2) != 0,
+                            (enabled & 4) != 0,
+                            48000,
+                            200,
+                            6000,
+                            3000});
+  }
+}
+
+TEST(LineFilterBankTest, FrequenciesStayBelowTheNyquistFrequency) {
+  // the top of the parameter ranges, for lines at a quarter of 48kHz
+  for (int enabled = 1; enabled < 8; enabled++) {
+    expectMatchesReference({(enabled & 1) != 0,
+                            (enabled & 2) != 0,
+                            (enabled & 4) != 0,
+                            12000,
+                            10000,
+                            19000,
+                            20000});
+  }
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "cloudseed/LineMixing.h"
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/presets.h"
+
+using namespace cloudSeed;
+
+static const LineMixing MIXINGS[] = {
+  LineMixing::Independent,
+  LineMixing::Householder,
+  LineMixing::Hadamard,
+};
+
+/**
+ * The matrix `mixing` applies to `count` lines, column j is where a sample
+ * of line j ends up.
+ */
+static std::vector<float> matrix(LineMixing mixing, size_t count) {
+  std::vector<float> columns(count * count);
+  std::vector<float> scratch(1);
+  for (size_t j = 0; j < count; j++) {
+    auto column = &columns[j * count];
+    column[j] = 1;
+    mixing::mix(mixing, column, 1, count, 1, scratch.data());
+  }
+  return columns;
+}
+
+TEST(LineMixingTest, MatricesAreOrthogonal) {
+  for (auto mixing : MIXINGS) {
+    for (size_t count = 1; count <= 8; count++) {
+      auto m = matrix(mixing, count);
+      for (size_t a = 0; a < count; a++) {
+        for (size_t b = 0; b < count; b++) {
+          float dot = 0;
+          for (size_t k = 0; k < count; k++)
+            dot += m[a * count + k] * m[b * count + k];
+          ASSERT_NEAR(a == b ? 1.0f : 0.0f, dot, 1e-6)
+            << (int)mixing << " " << count;
+        }
+      }
+    }
+  }
+}
+
+TEST(LineMixingTest, HadamardSpreadsEveryLineEvenly) {
+  auto m = matrix(LineMixing::Hadamard, 4);
+  for (auto value : m)
+    EXPECT_FLOAT_EQ(0.5f, std::fabs(value));
+}
+
+/**
+ * Renders an impulse through 4 lines with the diffusers and taps off, so the
+ * echoes come from the lines alone.
+ */
+static std::vector<float> impulseResponse(ReverbController& reverb,
+                                          LineMixing mixing) {
+  float parameters[(int)Parameter::Count] = {};
+  presets::FACTORY_PROGRAMS[5].init(parameters);
+  parameters[(int)Parameter::LineCount] = 3 / 11.0;
+  parameters[(int)Parameter::TapCount] = 0;
+  parameters[(int)Parameter::DiffusionEnabled] = 0;
+  parameters[(int)Parameter::LateDiffusionEnabled] = 0;
+  parameters[(int)Parameter::DryOut] = 0;
+  parameters[(int)Parameter::PredelayOut] = 0;
+  parameters[(int)Parameter::EarlyOut] = 0;
+  reverb.setAllParameters(parameters);
+  reverb.setLineMixing(mixing);
+  reverb.updateControls();
+  reverb.clearBuffers();
+
+  std::vector<float> response(48000 * 3);
+  response[0] = 1;
+  for (size_t i = 0; i < response.size(); i += 64)
+    reverb.process(&response[i], &response[i], 64);
+  return response;
+}
+
+TEST(LineMixingTest, MixedLinesBuildDensityFaster) {
+  // the pool is never freed, one engine renders every response
+  std::unique_ptr<ReverbController> reverb(new ReverbController(48000, 64));
+  const size_t window = 24000;
+
+  // the samples within 60dB of the peak past the first window
+  auto density = [&](const std::vector<float>& response) {
+    float peak = 0;
+    for (auto sample : response)
+      peak = std::max(peak, std::fabs(sample));
+    size_t echoes = 0;
+    for (size_t i = window; i < response.size(); i++)
+      echoes += std::fabs(response[i]) > peak * 1e-3f;
+    return echoes;
+  };
+  auto energy = [&](const std::vector<float>& response, size_t start) {
+    double sum = 0;
+    for (size_t i = start; i < start + window; i++)
+      sum += response[i] * response[i];
+    return sum;
+  };
+
+  auto independent = impulseResponse(*reverb, LineMixing::Independent);
+  for (auto mixing : {LineMixing::Householder, LineMixing::Hadamard}) {
+    auto mixed = impulseResponse(*reverb, mixing);
+    EXPECT_GT(density(mixed), 4 * density(independent)) << (int)mixing;
+    // and still decays
+    EXPECT_LT(energy(mixed, mixed.size() - window), energy(mixed, window))
+      << (int)mixing;
+  }
+}
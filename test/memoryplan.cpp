@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "allocator.hpp"
+#include "cloudseed/MemoryPlan.h"
+#include "cloudseed/ReverbController.h"
+
+using namespace cloudSeed;
+
+TEST(MemoryPlanTest, PlanMatchesTheArenaUse) {
+  StorageConfig compact;
+  compact.line_delay = SampleFormat::Int16;
+  compact.line_diffuser = SampleFormat::Float16;
+  const EngineConfig configs[] = {
+    FIRMWARE_CONFIG, {44100, 64, compact}, {96000, 1, StorageConfig()}};
+
+  auto& fast = fastArena();
+  auto& sdram = sdramArena();
+  for (auto& config : configs) {
+    // start on aligned offsets, as the plan does
+    fast.allocate(0, "test");
+    sdram.allocate(0, "test");
+    auto fast_mark = fast.mark();
+    auto sdram_mark = sdram.mark();
+    {
+      std::unique_ptr<ReverbController> reverb(new ReverbController(
+        config.sample_rate, config.block_size, config.storage));
+      auto plan = planMemory(config);
+      auto fast_used = fast.used() - fast_mark;
+      auto used = fast_used + sdram.used() - sdram_mark;
+      EXPECT_LE(fast_used, plan.fast) << config.sample_rate;
+      // what did not fit the fast arena moved to SDRAM
+      EXPECT_LE(used, plan.fast + plan.sdram) << config.sample_rate;
+      // only the padding after the last allocation in each is not used
+      EXPECT_LT(plan.fast + plan.sdram - used, 2 * (size_t)ARENA_ALIGNMENT)
+        << config.sample_rate;
+    }
+    fast.rewind(fast_mark);
+    sdram.rewind(sdram_mark);
+  }
+}
+
+TEST(MemoryPlanTest, StagesReachTheLongestParameters) {
+  std::unique_ptr<ReverbController> reverb(new ReverbController());
+  for (int i = 0; i < (int)Parameter::Count; i++)
+    reverb->setParameter((Parameter)i, 1.0);
+
+  auto ms = [&](Parameter param) {
+    return reach::msToSamples(reverb->getScaledParameter(param),
+                              MCU_CLOCK_RATE);
+  };
+  auto mod = reverb->getScaledParameter(Parameter::LineModAmount);
+  EXPECT_LE(ms(Parameter::PreDelay), reach::preDelay(MCU_CLOCK_RATE));
+  EXPECT_LE(ms(Parameter::TapLength),
+            reach::multitap(MCU_CLOCK_RATE, MAX_DIFFUSER_TAPS));
+  EXPECT_LE(reach::msToSamples(
+              reverb->getScaledParameter(Parameter::DiffusionDelay) +
+                1.15 * mod,
+              MCU_CLOCK_RATE),
+            reach::diffuserStage(MCU_CLOCK_RATE));
+  EXPECT_LE(reach::msToSamples(
+              1.5 * reverb->getScaledParameter(Parameter::LineDelay) + mod,
+              MCU_CLOCK_RATE),
+            reach::lineDelay(MCU_CLOCK_RATE));
+
+  // and no further than a sample of rounding past them
+  EXPECT_GE(ms(Parameter::PreDelay) + 1, reach::preDelay(MCU_CLOCK_RATE));
+  EXPECT_GE(reach::msToSamples(
+              1.5 * reverb->getScaledParameter(Parameter::LineDelay) + mod,
+              MCU_CLOCK_RATE) +
+              1,
+            reach::lineDelay(MCU_CLOCK_RATE));
+}
+
+TEST(MemoryPlanTest, DelaysPastTheReachAreClamped) {
+  LfoBank lfo(1, 4, 1);
+  ModulatedDelay delay(100, 4, lfo);
+  delay.clearBuffers();
+  delay.ksample_delay = 1000;
+
+  // a longer delay would wrap the ring and come round early
+  float block[4] = {};
+  size_t arrival = 0;
+  for (size_t i = 0; i < 1000 / 4 && arrival == 0; i++) {
+    // past the first modulation update, which picks up the delay
+    block[0] = i == 4 ? 1 : 0;
+    lfo.tick(4);
+    auto out = delay.tick(block, 4);
+    for (size_t j = 0; j < 4; j++) {
+      if (out[j] > 0.5)
+        arrival = i * 4 + j - 16;
+    }
+  }
+  EXPECT_EQ(arrival, 100u);
+}
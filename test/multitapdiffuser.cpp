@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "cloudseed/MultitapDiffuser.h"
+
+using namespace cloudSeed;
+
+#define TEST_MAX_DELAY 1500
+#define TEST_BLOCK 64
+
+static std::vector<float> noise(size_t len, std::uint32_t seed) {
+  std::vector<float> samples(len);
+  for (auto& sample : samples) {
+    seed = seed * 1664525 + 1013904223;
+    sample = (seed >> 8) / (float)(1 << 24) - 0.5f;
+  }
+  return samples;
+}
+
+/**
+ * Every tap per sample over the whole input history, with no ring to wrap.
+ * The taps are summed in the same order as the diffuser sums them.
+ */
+static float sampleMajor(MultitapDiffuser& diffuser,
+                         const std::vector<float>& history,
+                         size_t n) {
+  float output = 0.0;
+  for (size_t j = 0; j < diffuser.getTapCount(); j++) {
+    auto offset = diffuser.getTapOffsets()[j];
+    float sample = offset <= n ? history[n - offset] : 0.0f;
+    output += sample * diffuser.getTapGains()[j];
+  }
+  return output;
+}
+
+/**
+ * Runs `tap_count` taps through blocks that never divide the ring, changing
+ * the tap length halfway, and checks every sample against sampleMajor().
+ */
+static void expectMatchesSampleMajor(size_t tap_count) {
+  auto& fast = fastArena();
+  auto& sdram = sdramArena();
+  auto fast_mark = fast.mark();
+  auto sdram_mark = sdram.mark();
+  {
+    std::unique_ptr<MultitapDiffuser> diffuser(
+      new MultitapDiffuser(TEST_MAX_DELAY, TEST_BLOCK));
+    diffuser->setSeed(7);
+    diffuser->setTapCount(tap_count);
+    diffuser->setTapLength(TEST_MAX_DELAY);
+    diffuser->setTapDecay(0.5);
+    diffuser->setTapGain(0.8);
+    diffuser->clearBuffers();
+
+    // long enough to wrap the ring several times
+    auto input = noise(20000, tap_count);
+    const size_t blocks[] = {TEST_BLOCK, 1, 37, 13};
+    size_t done = 0;
+    for (size_t b = 0; done < input.size(); b++) {
+      // the taps shrink while the ring still holds the older input
+      if (b == 200)
+        diffuser->setTapLength(TEST_MAX_DELAY / 3);
+
+      auto len = std::min(blocks[b % 4], input.size() - done);
+      auto output = diffuser->tick(&input[done], len);
+      for (size_t i = 0; i < len; i++) {
+        ASSERT_EQ(output[i], sampleMajor(*diffuser, input, done + i))
+          << tap_count << " taps, block " << b << " at " << done + i;
+      }
+      done += len;
+    }
+  }
+  fast.rewind(fast_mark);
+  sdram.rewind(sdram_mark);
+}
+
+TEST(MultitapDiffuserTest, BlocksMatchASampleMajorReference) {
+  expectMatchesSampleMajor(1);
+  expectMatchesSampleMajor(MAX_DIFFUSER_TAPS);
+}
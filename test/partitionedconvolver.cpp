@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "cloudseed/PartitionedConvolver.h"
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/presets.h"
+
+using namespace cloudSeed;
+
+static std::vector<float> noise(size_t len, std::uint32_t seed) {
+  std::vector<float> samples(len);
+  for (auto& sample : samples) {
+    seed = seed * 1664525 + 1013904223;
+    sample = (seed >> 8) / (float)(1 << 24) - 0.5f;
+  }
+  return samples;
+}
+
+TEST(RealFftTest, MatchesADirectTransform) {
+  const size_t size = 64;
+  RealFft fft(size, "test");
+  auto signal = noise(size, 1);
+
+  std::vector<float> re(size / 2 + 1), im(size / 2 + 1);
+  fft.forward(signal.data(), re.data(), im.data());
+  for (size_t k = 0; k <= size / 2; k++) {
+    double dft_re = 0, dft_im = 0;
+    for (size_t n = 0; n < size; n++) {
+      dft_re += signal[n] * std::cos(2 * M_PI * k * n / size);
+      dft_im -= signal[n] * std::sin(2 * M_PI * k * n / size);
+    }
+    EXPECT_NEAR(re[k], dft_re, 1e-4) << k;
+    EXPECT_NEAR(im[k], dft_im, 1e-4) << k;
+  }
+
+  std::vector<float> round_trip(size);
+  fft.inverse(re.data(), im.data(), round_trip.data());
+  for (size_t n = 0; n < size; n++)
+    EXPECT_NEAR(round_trip[n], signal[n], 1e-6) << n;
+}
+
+TEST(PartitionedConvolverTest, MatchesADirectConvolution) {
+  auto input = noise(3000, 2);
+  // shorter than a partition, exactly one or two, and many with a remainder
+  for (size_t length : {1, 20, 32, 33, 64, 1000}) {
+    auto response = noise(length, 3);
+    PartitionedConvolver convolver(32, 1000);
+    convolver.setImpulseResponse(response.data(), response.size());
+
+    // uneven calls, some across the partition boundaries
+    const size_t calls[] = {1, 7, 32, 100, 45};
+    std::vector<float> output(input.size());
+    size_t done = 0;
+    for (size_t call = 0; done < input.size(); call++) {
+      auto len = std::min(calls[call % 5], input.size() - done);
+      convolver.process(&input[done], &output[done], len);
+      done += len;
+    }
+
+    for (size_t n = 0; n < input.size(); n++) {
+      double expected = 0;
+      for (size_t k = 0; k < length && k <= n; k++)
+        expected += response[k] * input[n - k];
+      ASSERT_NEAR(output[n], expected, 1e-4) << length << " at " << n;
+    }
+  }
+}
+
+TEST(PartitionedConvolverTest, FrozenPresetMatchesTheEngine) {
+  auto& fast = fastArena();
+  auto& sdram = sdramArena();
+  auto fast_mark = fast.mark();
+  auto sdram_mark = sdram.mark();
+  {
+    std::unique_ptr<ReverbController> reverb(new ReverbController(48000, 64));
+    float parameters[(int)Parameter::Count] = {};
+    presets::FACTORY_PROGRAMS[8].init(parameters);
+    // the modulation is all that varies over time
+    parameters[(int)Parameter::EarlyDiffusionModAmount] = 0;
+    parameters[(int)Parameter::LineModAmount] = 0;
+    parameters[(int)Parameter::LateDiffusionModAmount] = 0;
+    reverb->setAllParameters(parameters);
+    reverb->updateControls();
+
+    // only lags past the response are cut, which the compared output has not
+    // reached yet
+    const size_t length = 48000;
+    std::vector<float> response(length);
+    auto rendered = reverb->renderImpulseResponse(response.data(), length);
+    EXPECT_GT(rendered, length / 2);
+
+    auto input = noise(length, 4);
+    std::fill(input.begin() + 12000, input.end(), 0.0f);
+    std::vector<float> live(length), frozen(length);
+    reverb->process(input.data(), live.data(), length);
+
+    std::unique_ptr<PartitionedConvolver> convolver(
+      new PartitionedConvolver(CONVOLUTION_PARTITION_SIZE, length));
+    convolver->setImpulseResponse(response.data(), length);
+    convolver->process(input.data(), frozen.data(), length);
+
+    float peak = 0;
+    for (auto sample : live)
+      peak = std::max(peak, std::fabs(sample));
+    EXPECT_GT(peak, 0.01f);
+    for (size_t n = 0; n < length; n++)
+      ASSERT_NEAR(frozen[n], live[n], peak * 1e-4f) << n;
+  }
+  fast.rewind(fast_mark);
+  sdram.rewind(sdram_mark);
+}
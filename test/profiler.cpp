@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "cloudseed/Profiler.h"
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/presets.h"
+
+using namespace cloudSeed;
+
+TEST(CycleHistogramTest, BucketsCoverEveryValueInOrder) {
+  EXPECT_EQ(CycleHistogram::bucket(0), 0u);
+  EXPECT_EQ(CycleHistogram::bucket(UINT32_MAX), PROFILER_BUCKETS - 1u);
+  EXPECT_EQ(CycleHistogram::upperBound(PROFILER_BUCKETS - 1), UINT32_MAX);
+
+  for (size_t b = 1; b < PROFILER_BUCKETS; b++) {
+    auto low = CycleHistogram::upperBound(b - 1) + 1;
+    auto high = CycleHistogram::upperBound(b);
+    ASSERT_EQ(CycleHistogram::bucket(low), b);
+    ASSERT_EQ(CycleHistogram::bucket(high), b);
+    // within an eighth of the values it holds
+    ASSERT_LE(high - low, low / 8) << b;
+  }
+}
+
+TEST(CycleHistogramTest, Statistics) {
+  CycleHistogram histogram;
+  EXPECT_EQ(histogram.getCount(), 0u);
+  EXPECT_EQ(histogram.getMin(), 0u);
+  EXPECT_EQ(histogram.getPercentile(0.99), 0u);
+
+  // 990 fast blocks and 10 slow ones
+  for (int i = 0; i < 990; i++)
+    histogram.record(1000 + i % 10);
+  for (int i = 0; i < 10; i++)
+    histogram.record(50000 + i);
+
+  EXPECT_EQ(histogram.getCount(), 1000u);
+  EXPECT_EQ(histogram.getMin(), 1000u);
+  EXPECT_EQ(histogram.getMax(), 50009u);
+  EXPECT_NEAR(histogram.getMean(), (990 * 1004.5 + 10 * 50004.5) / 1000, 1e-6);
+  // the slow blocks are the last percent
+  EXPECT_GE(histogram.getPercentile(0.99), 1009u);
+  EXPECT_LE(histogram.getPercentile(0.99), 1009u * 9 / 8);
+  EXPECT_GE(histogram.getPercentile(0.995), 50000u);
+  EXPECT_EQ(histogram.getPercentile(1.0), 50009u);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.getCount(), 0u);
+  EXPECT_EQ(histogram.getMax(), 0u);
+}
+
+TEST(ProfilerTest, StagesAreAddedOnce) {
+  std::unique_ptr<Profiler> profiler(new Profiler());
+  auto first = profiler->add("first");
+  EXPECT_EQ(profiler->add("second"), first + 1);
+  EXPECT_EQ(profiler->add("first"), first);
+  EXPECT_EQ(profiler->getStageCount(), 2u);
+
+  // a full profiler records the stages past it nowhere
+  static char names[PROFILER_MAX_STAGES][8];
+  for (size_t s = 2; s < PROFILER_MAX_STAGES; s++) {
+    std::snprintf(names[s], sizeof(names[s]), "s%zu", s);
+    EXPECT_EQ(profiler->add(names[s]), s);
+  }
+  auto past = profiler->add("past");
+  EXPECT_EQ(past, (size_t)PROFILER_MAX_STAGES);
+  profiler->record(past, 5);
+
+  profiler->record(first, 5);
+  EXPECT_EQ(profiler->getHistogram(first).getCount(), 1u);
+  profiler->requestReset();
+  EXPECT_EQ(profiler->getHistogram(first).getCount(), 1u);
+  profiler->record(first, 7);
+  EXPECT_EQ(profiler->getHistogram(first).getCount(), 1u);
+  EXPECT_EQ(profiler->getHistogram(first).getMin(), 7u);
+}
+
+TEST(ProfilerTest, EngineRecordsEveryStagePerBlock) {
+  auto& fast = fastArena();
+  auto& sdram = sdramArena();
+  auto fast_mark = fast.mark();
+  auto sdram_mark = sdram.mark();
+  {
+    // the modulation runs on across clears, so the timed engine is another
+    std::unique_ptr<ReverbController> reverb(new ReverbController(48000, 64));
+    std::unique_ptr<ReverbController> timed(new ReverbController(48000, 64));
+    float parameters[(int)Parameter::Count] = {};
+    presets::FACTORY_PROGRAMS[8].init(parameters);
+    parameters[(int)Parameter::DiffusionEnabled] = 1;
+    parameters[(int)Parameter::LineCount] = 1;
+    for (auto engine : {reverb.get(), timed.get()}) {
+      engine->setAllParameters(parameters);
+      engine->updateControls();
+      engine->clearBuffers();
+    }
+
+    std::vector<float> input(6400);
+    for (size_t n = 0; n < 2000; n++)
+      input[n] = ((n * 7919) % 1000) / 1000.0f - 0.5f;
+    std::vector<float> expected(input.size()), actual(input.size());
+    reverb->process(input.data(), expected.data(), input.size());
+
+    std::unique_ptr<Profiler> profiler(new Profiler());
+    timed->setProfiler(profiler.get());
+    timed->process(input.data(), actual.data(), input.size());
+
+    // timing leaves the output alone
+    for (size_t n = 0; n < input.size(); n++)
+      ASSERT_EQ(expected[n], actual[n]) << n;
+
+    ASSERT_GT(profiler->getStageCount(), 0u);
+    EXPECT_STREQ(profiler->getName(0), "channel");
+    for (size_t s = 0; s < profiler->getStageCount(); s++) {
+      auto name = profiler->getName(s);
+      auto& histogram = profiler->getHistogram(s);
+      // every line and stage runs, the resamplers are not added at the full
+      // rate
+      EXPECT_STRNE(name, "decimator");
+      EXPECT_STRNE(name, "interpolator");
+      EXPECT_EQ(histogram.getCount(), 100u) << name;
+      EXPECT_LE(histogram.getMax(), profiler->getHistogram(0).getMax())
+        << name;
+    }
+
+    timed->setProfiler(nullptr);
+    timed->process(input.data(), actual.data(), 64);
+    EXPECT_EQ(profiler->getHistogram(0).getCount(), 100u);
+  }
+  fast.rewind(fast_mark);
+  sdram.rewind(sdram_mark);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/Resampler.h"
+#include "cloudseed/presets.h"
+
+using namespace cloudSeed;
+
+static std::vector<float> sine(size_t len, double frequency) {
+  std::vector<float> samples(len);
+  for (size_t n = 0; n < len; n++)
+    samples[n] = std::sin(2 * M_PI * frequency * n / 48000);
+  return samples;
+}
+
+/**
+ * Runs `input` down by `factor` and back up in uneven calls.
+ */
+static std::vector<float> roundTrip(const std::vector<float>& input,
+                                    size_t factor) {
+  Decimator decimator(factor, "test");
+  Interpolator interpolator(factor, "test");
+  std::vector<float> low(Decimator::outputLength(input.size(), factor));
+  std::vector<float> output(input.size());
+
+  const size_t calls[] = {1, 3, 64, 17, 4};
+  size_t done = 0;
+  for (size_t call = 0; done < input.size(); call++) {
+    auto len = std::min(calls[call % 5], input.size() - done);
+    auto count = decimator.process(&input[done], low.data(), len);
+    EXPECT_LE(count, Decimator::outputLength(len, factor));
+    interpolator.process(low.data(), &output[done], len);
+    done += len;
+  }
+  return output;
+}
+
+static double rms(const float* samples, size_t len) {
+  double sum = 0;
+  for (size_t n = 0; n < len; n++)
+    sum += samples[n] * samples[n];
+  return std::sqrt(sum / len);
+}
+
+TEST(ResamplerTest, PassesTheBandBelowTheLowRate) {
+  for (size_t factor : {2, 4}) {
+    // well inside the passband of the low rate
+    auto input = sine(4800, 1000.0 / factor);
+    auto output = roundTrip(input, factor);
+
+    auto delay = resampling::delay(factor);
+    for (size_t n = 1000; n < input.size(); n++)
+      ASSERT_NEAR(output[n], input[n - delay], 1e-2) << factor << " at " << n;
+  }
+}
+
+TEST(ResamplerTest, TakesOutTheBandAboveTheLowRate) {
+  for (size_t factor : {2, 4}) {
+    // past the low Nyquist frequency, it would alias back into the band
+    auto input = sine(4800, 0.75 * 24000);
+    auto output = roundTrip(input, factor);
+    EXPECT_LT(rms(&output[1000], 3800), 0.01 * rms(&input[1000], 3800))
+      << factor;
+  }
+}
+
+TEST(ResamplerTest, SkippingMatchesRunningSilence) {
+  for (size_t factor : {2, 4}) {
+    Decimator run(factor, "test");
+    Decimator skipped(factor, "test");
+    std::vector<float> silence(64), low(64);
+    for (size_t len : {1, 3, 6, 7}) {
+      EXPECT_EQ(skipped.skip(len), run.process(silence.data(), low.data(), len))
+        << factor << " after " << len;
+    }
+  }
+}
+
+TEST(ResamplerTest, ReducedLateRateEngine) {
+  auto& fast = fastArena();
+  auto& sdram = sdramArena();
+
+  for (auto rate : {LateRate::Half, LateRate::Quarter}) {
+    auto fast_mark = fast.mark();
+    auto sdram_mark = sdram.mark();
+    {
+      auto before = sdram.used();
+      std::unique_ptr<ReverbController> whole(
+        new ReverbController(48000, 64, StorageConfig(), rate));
+      std::unique_ptr<ReverbController> chunked(
+        new ReverbController(48000, 64, StorageConfig(), rate));
+      // the late lines take most of the delay memory
+      EXPECT_LT(sdram.used() - before,
+                ReverbController::arenaBytes(
+                  MemoryTier::Bulk, 48000, 64, StorageConfig()) *
+                  2 * 3 / 4);
+
+      float parameters[(int)Parameter::Count] = {};
+      presets::FACTORY_PROGRAMS[8].init(parameters);
+      parameters[(int)Parameter::DryOut] = 0;
+      parameters[(int)Parameter::EarlyOut] = 0;
+      for (auto reverb : {whole.get(), chunked.get()}) {
+        reverb->setAllParameters(parameters);
+        reverb->updateControls();
+        reverb->clearBuffers();
+      }
+
+      std::vector<float> input(96000);
+      for (size_t n = 0; n < 2000; n++)
+        input[n] = ((n * 7919) % 1000) / 1000.0f - 0.5f;
+      std::vector<float> expected(input.size());
+      whole->process(input.data(), expected.data(), input.size());
+
+      // uneven chunks, the resamplers keep their phase across them
+      auto actual = input;
+      size_t pos = 0;
+      size_t chunk = 1;
+      while (pos < actual.size()) {
+        auto len = std::min(chunk, actual.size() - pos);
+        chunked->process(&actual[pos], &actual[pos], len);
+        pos += len;
+        chunk = chunk % 150 + 37;
+      }
+      for (size_t n = 0; n < input.size(); n++)
+        ASSERT_FLOAT_EQ(expected[n], actual[n]) << (int)rate << " at " << n;
+
+      // a tail that is there and dies away
+      auto early = rms(&expected[0], 24000);
+      auto late = rms(&expected[72000], 24000);
+      EXPECT_GT(early, 1e-3) << (int)rate;
+      EXPECT_LT(late, early) << (int)rate;
+    }
+    fast.rewind(fast_mark);
+    sdram.rewind(sdram_mark);
+  }
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/presets.h"
+
+using cloudSeed::Parameter;
+using cloudSeed::ReverbController;
+
+static std::unique_ptr<ReverbController> makeReverb() {
+  return std::unique_ptr<ReverbController>(new ReverbController(48000, 64));
+}
+
+static void loadPreset(ReverbController& reverb, size_t preset) {
+  float parameters[(int)Parameter::Count] = {};
+  cloudSeed::presets::FACTORY_PROGRAMS[preset].init(parameters);
+  reverb.setAllParameters(parameters);
+  reverb.updateControls();
+  reverb.clearBuffers();
+}
+
+static std::vector<float> makeInput() {
+  std::vector<float> input(48000);
+  for (size_t i = 0; i < 2000; i++)
+    input[i] = ((i * 7919) % 1000) / 1000.0f - 0.5f;
+  return input;
+}
+
+TEST(ReverbControllerTest, ProcessMatchesAcrossFrameCounts) {
+  // the pool is never freed, so both engines are reused for every preset
+  auto whole = makeReverb();
+  auto chunked = makeReverb();
+
+  for (size_t preset = 0; preset < FACTORY_PROGRAM_COUNT; preset++) {
+    loadPreset(*whole, preset);
+    loadPreset(*chunked, preset);
+
+    auto input = makeInput();
+    std::vector<float> expected(input.size());
+    whole->process(input.data(), expected.data(), input.size());
+
+    // uneven chunks, processed in place
+    auto actual = input;
+    size_t pos = 0;
+    size_t chunk = 1;
+    while (pos < actual.size()) {
+      auto len = std::min(chunk, actual.size() - pos);
+      chunked->process(&actual[pos], &actual[pos], len);
+      pos += len;
+      chunk = chunk % 150 + 37;
+    }
+
+    for (size_t i = 0; i < input.size(); i++) {
+      ASSERT_FLOAT_EQ(expected[i], actual[i])
+        << cloudSeed::presets::FACTORY_PROGRAMS[preset].name << " sample "
+        << i;
+    }
+  }
+}
+
+TEST(ReverbControllerTest, IdleSkipsOnlyASilentTail) {
+  auto skipping = makeReverb();
+  auto running = makeReverb();
+  running->setIdleDetection(false);
+  loadPreset(*skipping, 3);
+  loadPreset(*running, 3);
+
+  auto burst = makeInput();
+  std::vector<float> silence(48000, 0.0f);
+  std::vector<float> expected(48000);
+  std::vector<float> actual(48000);
+
+  // the first burst, its tail, then the second burst
+  const std::vector<float>* inputs[] = {
+    &burst, &silence, &silence, &silence, &silence, &silence, &burst};
+  bool went_idle = false;
+  for (auto input : inputs) {
+    for (size_t i = 0; i < input->size(); i += 64) {
+      running->process(input->data() + i, expected.data() + i, 64);
+      skipping->process(input->data() + i, actual.data() + i, 64);
+      went_idle = went_idle || skipping->isIdle();
+    }
+    for (size_t i = 0; i < expected.size(); i++)
+      ASSERT_NEAR(actual[i], expected[i], 0.0002) << "sample " << i;
+  }
+
+  EXPECT_TRUE(went_idle);
+  EXPECT_FALSE(skipping->isIdle());
+  EXPECT_FALSE(running->isIdle());
+}
+
+TEST(ReverbControllerTest, RequestedClearMatchesAClearAtOnce) {
+  auto at_once = makeReverb();
+  auto requested = makeReverb();
+  loadPreset(*at_once, 5);
+  loadPreset(*requested, 5);
+
+  auto burst = makeInput();
+  std::vector<float> expected(burst.size());
+  std::vector<float> actual(burst.size());
+  at_once->process(burst.data(), expected.data(), burst.size());
+  requested->process(burst.data(), actual.data(), burst.size());
+
+  at_once->clearBuffers();
+  requested->requestClear();
+  EXPECT_TRUE(requested->isClearing());
+
+  // only the dry signal until the memory is zeroed, the modulators carry on
+  // in both
+  float silence[64] = {};
+  size_t blocks = 0;
+  while (requested->isClearing()) {
+    at_once->process(silence, expected.data(), 64);
+    requested->process(silence, actual.data(), 64);
+    for (size_t i = 0; i < 64; i++)
+      ASSERT_EQ(0.0f, actual[i]);
+    blocks++;
+  }
+  EXPECT_GT(blocks, 1u);
+
+  at_once->process(burst.data(), expected.data(), burst.size());
+  requested->process(burst.data(), actual.data(), burst.size());
+  for (size_t i = 0; i < burst.size(); i++)
+    ASSERT_FLOAT_EQ(expected[i], actual[i]) << "sample " << i;
+}
+
+TEST(ReverbControllerTest, SwitchingDiffusersClearsThemOverBlocks) {
+  auto reverb = makeReverb();
+  loadPreset(*reverb, 0);
+  // nothing was written to them since the clear
+  reverb->setParameter(Parameter::DiffusionEnabled, 1);
+  reverb->setParameter(Parameter::LateDiffusionEnabled, 1);
+  EXPECT_FALSE(reverb->isClearing());
+
+  auto burst = makeInput();
+  std::vector<float> output(burst.size());
+  reverb->process(burst.data(), output.data(), 4096);
+
+  reverb->setParameter(Parameter::DiffusionEnabled, 0);
+  reverb->setParameter(Parameter::LateDiffusionEnabled, 0);
+  EXPECT_TRUE(reverb->isClearing());
+
+  // the tail carries on through the lines while the diffusers are zeroed
+  size_t blocks = 0;
+  float peak = 0;
+  for (size_t i = 4096; reverb->isClearing(); i += 4, blocks++) {
+    reverb->process(burst.data() + i, output.data() + i, 4);
+    for (size_t j = 0; j < 4; j++)
+      peak = std::max(peak, std::fabs(output[i + j]));
+  }
+  EXPECT_GT(blocks, 1u);
+  EXPECT_GT(peak, 0.0f);
+}
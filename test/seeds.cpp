@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cloudseed/FactorySeeds.h"
+#include "cloudseed/ReverbController.h"
+#include "cloudseed/presets.h"
+
+using cloudSeed::Parameter;
+using cloudSeed::ReverbController;
+namespace seeds = cloudSeed::seeds;
+namespace sharandom = audioLib::sharandom;
+
+// v[0], v[1], v[8] and v[99] of each seed's expansion, from the original
+// implementation
+struct Reference {
+  long long seed;
+  float values[4];
+};
+
+static const Reference REFERENCES[] = {
+  {0, {0.95874536f, 0.476738065f, 0.901263654f, 0.559719384f}},
+  {1, {0.213403672f, 0.649402738f, 0.856691658f, 0.575862944f}},
+  {-5, {0.391911477f, 0.077178143f, 0.689721406f, 0.297564924f}},
+  {1150, {0.343817711f, 0.288978904f, 0.728731573f, 0.215315327f}},
+  {23456, {0.930173874f, 0.676647961f, 0.570079625f, 0.967125475f}},
+  {4294967297, {0.724715054f, 0.315686584f, 0.751573682f, 0.483425498f}},
+};
+
+TEST(SeedsTest, MatchesTheOriginalExpansion) {
+  for (auto& reference : REFERENCES) {
+    float values[100];
+    sharandom::generate(reference.seed, values, 100);
+    EXPECT_FLOAT_EQ(values[0], reference.values[0]) << reference.seed;
+    EXPECT_FLOAT_EQ(values[1], reference.values[1]) << reference.seed;
+    EXPECT_FLOAT_EQ(values[8], reference.values[2]) << reference.seed;
+    EXPECT_FLOAT_EQ(values[99], reference.values[3]) << reference.seed;
+  }
+}
+
+TEST(SeedsTest, ShorterExpansionsArePrefixes) {
+  float longer[100];
+  sharandom::expand(777, longer, 100);
+
+  // a cached seed is extended, then served shorter again
+  for (size_t count : {3, 50, 100, 9, 200}) {
+    std::vector<float> values(count);
+    sharandom::generate(777, values.data(), count);
+    for (size_t i = 0; i < std::min(count, (size_t)100); i++)
+      ASSERT_EQ(values[i], longer[i]) << count << " " << i;
+  }
+}
+
+TEST(SeedsTest, CachedSeedsSurviveEviction) {
+  float expected[10];
+  float values[10];
+  for (long long seed = 1000; seed < 1000 + 3 * SHARANDOM_CACHE_ENTRIES;
+       seed++) {
+    sharandom::expand(seed, expected, 10);
+    sharandom::generate(seed, values, 10);
+    for (int i = 0; i < 10; i++)
+      ASSERT_EQ(values[i], expected[i]) << seed;
+    // an evicted seed is hashed again
+    sharandom::generate(seed - SHARANDOM_CACHE_ENTRIES, values, 10);
+    sharandom::expand(seed - SHARANDOM_CACHE_ENTRIES, expected, 10);
+    for (int i = 0; i < 10; i++)
+      ASSERT_EQ(values[i], expected[i]) << seed;
+  }
+}
+
+TEST(SeedsTest, TableMatchesTheRuntimeExpansion) {
+  for (size_t i = 0; i < seeds::FACTORY_SEED_COUNT; i++) {
+    auto& entry = seeds::FACTORY_SEEDS[i];
+    std::vector<float> expected(entry.count);
+    std::vector<float> values(entry.count);
+    sharandom::expand(entry.seed, expected.data(), entry.count);
+    seeds::generate(entry.seed, values.data(), entry.count);
+    EXPECT_EQ(values, expected) << entry.seed;
+  }
+
+  // seeds outside the table still expand
+  float expected[6];
+  float values[6];
+  sharandom::expand(424242, expected, 6);
+  seeds::generate(424242, values, 6);
+  for (int i = 0; i < 6; i++)
+    EXPECT_EQ(values[i], expected[i]);
+}
+
+TEST(SeedsTest, FactoryProgramSeedsAreInTheTable) {
+  for (auto& program : cloudSeed::presets::FACTORY_PROGRAMS) {
+    float parameters[(int)Parameter::Count] = {};
+    program.init(parameters);
+    ReverbController reverb(48000, 64);
+    reverb.setAllParameters(parameters);
+
+    auto seed = [&](Parameter param) {
+      return (int)reverb.getScaledParameter(param);
+    };
+    EXPECT_TRUE(
+      seeds::contains(seed(Parameter::TapSeed), SEED_VALUES_TAPS))
+      << program.name;
+    EXPECT_TRUE(
+      seeds::contains(seed(Parameter::DiffusionSeed), SEED_VALUES_DIFFUSER))
+      << program.name;
+    EXPECT_TRUE(seeds::contains(seed(Parameter::DelaySeed),
+                                MAX_DELAY_LINES * 3))
+      << program.name;
+    for (int i = 0; i < MAX_DELAY_LINES; i++) {
+      auto post = seed(Parameter::PostDiffusionSeed) * (i + 1);
+      EXPECT_TRUE(seeds::contains(post, SEED_VALUES_DIFFUSER))
+        << program.name << " line " << i;
+    }
+  }
+}
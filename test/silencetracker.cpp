@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cloudseed/SilenceTracker.h"
+
+using cloudSeed::SilenceTracker;
+
+TEST(SilenceTrackerTest, StartsSilent) {
+  SilenceTracker tracker(100);
+  EXPECT_TRUE(tracker.isSilent());
+}
+
+TEST(SilenceTrackerTest, IsSilentOnceTheMemoryHasPassed) {
+  SilenceTracker tracker(100);
+  std::vector<float> block(32, 0.0f);
+  block[31] = 0.5f;
+  tracker.track(block.data(), block.size());
+  EXPECT_FALSE(tracker.isSilent());
+
+  // below the threshold counts as silent
+  std::fill(block.begin(), block.end(), 0.00001f);
+  for (int i = 0; i < 3; i++) {
+    tracker.track(block.data(), block.size());
+    EXPECT_FALSE(tracker.isSilent());
+  }
+  tracker.track(block.data(), block.size());
+  EXPECT_TRUE(tracker.isSilent());
+  tracker.track(block.data(), block.size());
+  EXPECT_TRUE(tracker.isSilent());
+
+  block[7] = -0.001f;
+  tracker.track(block.data(), block.size());
+  EXPECT_FALSE(tracker.isSilent());
+  tracker.reset();
+  EXPECT_TRUE(tracker.isSilent());
+}
+
+TEST(SilenceTrackerTest, PowerIsThePeak) {
+  float samples[] = {0.1f, -0.5f, 0.25f};
+  EXPECT_FLOAT_EQ(SilenceTracker::power(samples, 3), 0.25f);
+  EXPECT_FLOAT_EQ(SilenceTracker::power(samples, 1), 0.01f);
+  EXPECT_EQ(SilenceTracker::power(samples, 0), 0.0f);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "cloudseed/audiolib/valuetables.h"
+
+using namespace audioLib::valueTables;
+
+static_assert(detail::response(detail::LN_10).values[0] == 0 &&
+                detail::response(detail::LN_10).values[256] == 1,
+              "the tables are worked out at compile time");
+
+static const struct {
+  const Table& table;
+  double base;
+} RESPONSES[] = {
+  {Response2Oct, 4},
+  {Response3Oct, 8},
+  {Response4Oct, 16},
+  {Response5Oct, 32},
+  {Response6Oct, 64},
+  {Response2Dec, 100},
+  {Response3Dec, 1000},
+  {Response4Dec, 10000},
+};
+
+TEST(ValueTablesTest, EndsAreExactAndClamped) {
+  for (auto& response : RESPONSES) {
+    EXPECT_EQ(0.0f, Get(0, response.table)) << response.base;
+    EXPECT_EQ(1.0f, Get(1, response.table)) << response.base;
+    EXPECT_EQ(0.0f, Get(-0.5, response.table)) << response.base;
+    EXPECT_EQ(1.0f, Get(1.5, response.table)) << response.base;
+  }
+}
+
+TEST(ValueTablesTest, FollowsTheCurve) {
+  for (auto& response : RESPONSES) {
+    float previous = 0;
+    for (int i = 1; i <= 10000; i++) {
+      double x = i / 10000.0;
+      double expected = (std::pow(response.base, x) - 1) / (response.base - 1);
+      auto actual = Get(x, response.table);
+      // the first segment bends most relative to its size
+      auto tolerance = x < 0.1 ? 0.02 : 5e-4;
+      ASSERT_NEAR(expected, actual, expected * tolerance)
+        << response.base << " at " << x;
+      ASSERT_GE(actual, previous) << response.base << " at " << x;
+      previous = actual;
+    }
+  }
+}